@@ -0,0 +1,122 @@
+/***************************************************************************
+    Asset Cache.
+
+    A file of pre-decoded data, split into sections. Each section starts
+    on a page boundary, so the file can be memory mapped and used in place.
+
+    The cache is tied to a key (for example, the CRCs of the source ROMs)
+    and is rejected if the key, format or byte order does not match.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "assetcache.hpp"
+
+AssetCache::AssetCache()
+{
+    header = NULL;
+}
+
+AssetCache::~AssetCache()
+{
+    close();
+}
+
+bool AssetCache::open(const std::string& filename, uint32_t key, const uint32_t* lengths, int count)
+{
+    close();
+
+    if (count > SECTIONS || !file.open(filename.c_str()))
+        return false;
+
+    header = (const header_t*) file.data;
+
+    bool valid = file.length >= sizeof(header_t) &&
+                 memcmp(header->magic, "CBAC", 4) == 0 &&
+                 header->version    == VERSION &&
+                 header->byte_order == BYTE_ORDER_MARK &&
+                 header->key        == key &&
+                 header->count      == (uint32_t) count;
+
+    for (int i = 0; valid && i < count; i++)
+    {
+        valid = header->length[i] == lengths[i] &&
+                (header->offset[i] % ALIGN) == 0 &&
+                (uint64_t) header->offset[i] + header->length[i] <= file.length;
+    }
+
+    if (!valid)
+        close();
+
+    return valid;
+}
+
+void AssetCache::close()
+{
+    file.close();
+    header = NULL;
+}
+
+const uint8_t* AssetCache::get(int section) const
+{
+    if (header == NULL || section < 0 || section >= (int) header->count)
+        return NULL;
+
+    return file.data + header->offset[section];
+}
+
+bool AssetCache::save(const std::string& filename, uint32_t key, const section_t* sections, int count)
+{
+    if (count > SECTIONS)
+        return false;
+
+    header_t h;
+    memset(&h, 0, sizeof(header_t));
+    memcpy(h.magic, "CBAC", 4);
+    h.version    = VERSION;
+    h.byte_order = BYTE_ORDER_MARK;
+    h.key        = key;
+    h.count      = count;
+
+    uint32_t offset = ALIGN;
+    for (int i = 0; i < count; i++)
+    {
+        h.offset[i] = offset;
+        h.length[i] = sections[i].length;
+        offset += (sections[i].length + ALIGN - 1) & ~(ALIGN - 1);
+    }
+
+    const std::string temp = filename + ".tmp";
+    std::ofstream out(temp.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out)
+        return false;
+
+    std::vector<char> padding(ALIGN, 0);
+
+    out.write((const char*) &h, sizeof(header_t));
+    out.write(&padding[0], ALIGN - sizeof(header_t));
+
+    for (int i = 0; i < count; i++)
+    {
+        out.write((const char*) sections[i].data, sections[i].length);
+        out.write(&padding[0], (ALIGN - (sections[i].length % ALIGN)) % ALIGN);
+    }
+
+    out.close();
+    if (out.fail())
+    {
+        std::remove(temp.c_str());
+        return false;
+    }
+
+#ifdef _WIN32
+    std::remove(filename.c_str()); // rename() does not replace existing files on Windows
+#endif
+    return std::rename(temp.c_str(), filename.c_str()) == 0;
+}
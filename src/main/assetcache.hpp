@@ -0,0 +1,78 @@
+/***************************************************************************
+    Asset Cache.
+
+    A file of pre-decoded data, split into sections. Each section starts
+    on a page boundary, so the file can be memory mapped and used in place.
+
+    The cache is tied to a key (for example, the CRCs of the source ROMs)
+    and is rejected if the key, format or byte order does not match.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#pragma once
+
+#include <string>
+#include "stdint.hpp"
+#include "mappedfile.hpp"
+
+class AssetCache
+{
+public:
+    // Sections
+    enum
+    {
+        TILES,      // hwtiles: De-planarised tiles
+        SPRITES,    // hwsprites: Byte-swapped sprites
+        ROAD,       // HWRoad: Expanded road graphics
+        ROM0,       // Master CPU ROM
+        ROM1,       // Slave CPU ROM
+        Z80,        // Sound CPU ROM
+        PCM,        // Sega PCM samples
+        SECTIONS
+    };
+
+    // Alignment of each section in the file
+    const static uint32_t ALIGN = 4096;
+
+    struct section_t
+    {
+        const void* data;
+        uint32_t length;
+    };
+
+    AssetCache();
+    ~AssetCache();
+
+    // Map the cache file and check it against the key and expected section lengths
+    bool open(const std::string& filename, uint32_t key, const uint32_t* lengths, int count);
+    void close();
+    bool is_open() const { return file.is_open(); }
+
+    // Start of a section in the mapped file
+    const uint8_t* get(int section) const;
+
+    // Write a cache file. Written to a temporary file first, so a partial file is never used.
+    static bool save(const std::string& filename, uint32_t key, const section_t* sections, int count);
+
+private:
+    const static uint32_t VERSION = 1;
+
+    // Identifies the byte order of the machine that wrote the file
+    const static uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    struct header_t
+    {
+        char     magic[4];
+        uint32_t version;
+        uint32_t byte_order;
+        uint32_t key;
+        uint32_t count;
+        uint32_t offset[SECTIONS];
+        uint32_t length[SECTIONS];
+    };
+
+    MappedFile file;
+    const header_t* header;
+};
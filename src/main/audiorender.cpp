@@ -0,0 +1,322 @@
+/***************************************************************************
+    Offline Audio Renderer.
+
+    Runs the ported Z80 sound program, YM2151 and Sega PCM emulation without
+    an audio device, and writes the mixed output to a WAV file as fast as
+    the CPU allows.
+
+    The sound commands either come from a built in script, which plays
+    every music track and sound effect command, the engine and a passing
+    car, or from a session recorded with -record_audio. The time spent in
+    each chip is reported, which gives a fixed workload for benchmarking
+    the sound code.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include "audiorender.hpp"
+#include "frontend/config.hpp"
+#include "engine/audio/osoundint.hpp"
+
+typedef std::chrono::high_resolution_clock render_clock;
+
+static inline double elapsed(render_clock::time_point start)
+{
+    return std::chrono::duration<double>(render_clock::now() - start).count();
+}
+
+static void write16_le(std::ofstream& out, uint16_t v)
+{
+    out.put((char) (v & 0xFF));
+    out.put((char) (v >> 8));
+}
+
+static void write32_le(std::ofstream& out, uint32_t v)
+{
+    write16_le(out, v & 0xFFFF);
+    write16_le(out, v >> 16);
+}
+
+// ----------------------------------------------------------------------------
+// Script of sound commands
+// ----------------------------------------------------------------------------
+
+struct script_entry
+{
+    uint8_t cmd;      // Command to queue
+    uint8_t stop;     // Command to stop a looped effect (or 0)
+    uint8_t seconds;  // Time to render before stopping
+};
+
+static const uint8_t MUSIC_SECONDS = 30;
+static const uint8_t FX_SECONDS    = 3;
+
+static const script_entry SCRIPT[] =
+{
+    // Music
+    { sound::MUSIC_MAGICAL,    0,                      MUSIC_SECONDS },
+    { sound::MUSIC_BREEZE,     0,                      MUSIC_SECONDS },
+    { sound::MUSIC_SPLASH,     0,                      MUSIC_SECONDS },
+    { sound::MUSIC_LASTWAVE,   0,                      MUSIC_SECONDS },
+
+    // YM Effects
+    { sound::COIN_IN,          0,                      FX_SECONDS },
+    { sound::YM_CHECKPOINT,    0,                      FX_SECONDS },
+    { sound::BEEP1,            0,                      FX_SECONDS },
+    { sound::BEEP2,            0,                      FX_SECONDS },
+
+    // PCM Effects
+    { sound::INIT_SLIP,        sound::STOP_SLIP,       FX_SECONDS },
+    { sound::INIT_CHEERS,      sound::STOP_CHEERS,     FX_SECONDS },
+    { sound::INIT_CHEERS2,     sound::STOP_CHEERS,     FX_SECONDS },
+    { sound::CRASH1,           0,                      FX_SECONDS },
+    { sound::REBOUND,          0,                      FX_SECONDS },
+    { sound::CRASH2,           0,                      FX_SECONDS },
+    { sound::SIGNAL1,          0,                      FX_SECONDS },
+    { sound::SIGNAL2,          0,                      FX_SECONDS },
+    { sound::INIT_WEIRD,       sound::STOP_WEIRD,      FX_SECONDS },
+    { sound::INIT_SAFETYZONE,  sound::STOP_SAFETYZONE, FX_SECONDS },
+    { sound::VOICE_CHECKPOINT, 0,                      FX_SECONDS },
+    { sound::VOICE_CONGRATS,   0,                      FX_SECONDS },
+    { sound::VOICE_GETREADY,   0,                      FX_SECONDS },
+    { sound::PCM_WAVE,         0,                      FX_SECONDS },
+};
+
+// Engine pitch sweep: idle to top speed and back
+static const int ENGINE_SWEEP_SECONDS = 8;
+static const uint16_t ENGINE_PITCH_MAX = 0x3FE0;
+
+// Passing car on a traffic channel: approaches, pans from left to right and fades away
+static const int TRAFFIC_PASS_SECONDS = 4;
+static const int TRAFFIC_VOL_MAX = 0x1F;
+
+// Silence between entries, so effects don't overlap
+static const int GAP_FRAMES = 15;
+
+AudioRender::AudioRender()
+{
+    mix_buffer = NULL;
+    data_bytes = 0;
+}
+
+AudioRender::~AudioRender()
+{
+    delete[] mix_buffer;
+}
+
+bool AudioRender::render_script(const std::string& wav_filename)
+{
+    if (!begin(wav_filename, SCRIPT_FPS))
+        return false;
+
+    const int entries = sizeof(SCRIPT) / sizeof(script_entry);
+
+    for (int i = 0; i < entries; i++)
+    {
+        osoundint.queue_sound_service(SCRIPT[i].cmd);
+        frames(SCRIPT[i].seconds * SCRIPT_FPS);
+
+        if (SCRIPT[i].stop)
+            osoundint.queue_sound_service(SCRIPT[i].stop);
+        osoundint.queue_sound_service(sound::FM_RESET);
+        frames(GAP_FRAMES);
+    }
+
+    // Engine
+    const int sweep_frames = ENGINE_SWEEP_SECONDS * SCRIPT_FPS;
+    osoundint.engine_data[sound::ENGINE_VOL] = 0x3F;
+    for (int i = 0; i < sweep_frames; i++)
+    {
+        int pos = i < sweep_frames / 2 ? i : sweep_frames - i;
+        uint16_t pitch = (uint16_t) ((pos * 2 * ENGINE_PITCH_MAX) / sweep_frames);
+        osoundint.engine_data[sound::ENGINE_PITCH_H] = pitch >> 8;
+        osoundint.engine_data[sound::ENGINE_PITCH_L] = pitch & 0xFF;
+        frame();
+    }
+    osoundint.engine_data[sound::ENGINE_VOL] = 0;
+    frames(GAP_FRAMES);
+
+    // Traffic. Data is the same as OTraffic::traffic_sound(): volume in bits 3-7, panning (-3 to +3) in bits 0-2
+    const int pass_frames = TRAFFIC_PASS_SECONDS * SCRIPT_FPS;
+    for (int i = 0; i < pass_frames; i++)
+    {
+        int pos = i < pass_frames / 2 ? i : pass_frames - i;
+        int vol = 1 + ((pos * 2 * (TRAFFIC_VOL_MAX - 1)) / pass_frames);
+        int pan = ((i * 7) / pass_frames) - 3;
+        osoundint.engine_data[sound::TRAFFIC1] = (vol << 3) | (pan & 7);
+        frame();
+    }
+    osoundint.engine_data[sound::TRAFFIC1] = 0;
+    frames(GAP_FRAMES);
+
+    return end();
+}
+
+bool AudioRender::render_session(const std::string& log_filename, const std::string& wav_filename)
+{
+    std::ifstream log(log_filename.c_str(), std::ios::in | std::ios::binary);
+    if (!log)
+    {
+        std::cout << "Unable to open sound recording: " << log_filename << std::endl;
+        return false;
+    }
+
+    char header[6];
+    if (!log.read(header, sizeof(header)) || memcmp(header, "CBSR", 4) != 0 || header[4] != 1)
+    {
+        std::cout << "Not a valid sound recording: " << log_filename << std::endl;
+        return false;
+    }
+
+    if (!begin(wav_filename, header[5]))
+        return false;
+
+    char count;
+    while (log.get(count))
+    {
+        uint8_t cmds[0x100];
+        if (!log.read((char*) cmds, (uint8_t) count) || !log.read((char*) osoundint.engine_data, sizeof(osoundint.engine_data)))
+        {
+            std::cout << "Sound recording truncated" << std::endl;
+            break;
+        }
+
+        for (int i = 0; i < (uint8_t) count; i++)
+            osoundint.queue_sound_service(cmds[i]);
+
+        frame();
+    }
+
+    return end();
+}
+
+// ----------------------------------------------------------------------------
+// Rendering
+// ----------------------------------------------------------------------------
+
+bool AudioRender::begin(const std::string& wav_filename, int fps)
+{
+    if (fps != 30 && fps != 60)
+    {
+        std::cout << "Unsupported frame rate: " << fps << std::endl;
+        return false;
+    }
+
+    wav.open(wav_filename.c_str(), std::ios::out | std::ios::binary);
+    if (!wav)
+    {
+        std::cout << "Unable to create WAV file: " << wav_filename << std::endl;
+        return false;
+    }
+
+    config.fps = fps;
+    osoundint.has_booted = true;
+    osoundint.init();
+
+    delete[] mix_buffer;
+    mix_buffer = new int16_t[osoundint.pcm->buffer_size];
+
+    mixer.set_gain(Mixer::YM,     osoundint.ym->get_volume());
+    mixer.set_gain(Mixer::PCM,    osoundint.pcm->get_volume());
+    mixer.set_gain(Mixer::MASTER, config.sound.vol_master);
+
+    time_z80 = time_ym = time_pcm = time_mix = 0;
+    samples    = 0;
+    data_bytes = 0;
+
+    // Header. Sizes are filled in by end()
+    const uint16_t channels = 2;
+    wav.write("RIFF", 4);
+    write32_le(wav, 0);
+    wav.write("WAVEfmt ", 8);
+    write32_le(wav, 16);
+    write16_le(wav, 1); // PCM
+    write16_le(wav, channels);
+    write32_le(wav, config.sound.rate);
+    write32_le(wav, config.sound.rate * channels * sizeof(int16_t));
+    write16_le(wav, channels * sizeof(int16_t));
+    write16_le(wav, 16);
+    wav.write("data", 4);
+    write32_le(wav, 0);
+
+    return true;
+}
+
+void AudioRender::frame()
+{
+    render_clock::time_point t = render_clock::now();
+    osoundint.tick();
+    time_z80 += elapsed(t);
+
+    t = render_clock::now();
+    osoundint.ym->stream_update();
+    time_ym += elapsed(t);
+
+    t = render_clock::now();
+    osoundint.pcm->stream_update();
+    time_pcm += elapsed(t);
+
+    const uint32_t length = osoundint.pcm->buffer_size;
+    uint32_t wav_pos = 0;
+
+    t = render_clock::now();
+    mixer.mix(mix_buffer, osoundint.ym->get_buffer(), osoundint.pcm->get_buffer(), length, NULL, wav_pos, 0);
+    time_mix += elapsed(t);
+
+    for (uint32_t i = 0; i < length; i++)
+        write16_le(wav, mix_buffer[i]);
+
+    data_bytes += length * sizeof(int16_t);
+    samples    += length / 2;
+}
+
+void AudioRender::frames(int count)
+{
+    for (int i = 0; i < count; i++)
+        frame();
+}
+
+bool AudioRender::end()
+{
+    wav.seekp(4);
+    write32_le(wav, 36 + data_bytes);
+    wav.seekp(40);
+    write32_le(wav, data_bytes);
+    wav.close();
+
+    report();
+    return !wav.fail();
+}
+
+void AudioRender::report()
+{
+    const double audio_secs = samples / (double) config.sound.rate;
+
+    std::cout << "Rendered " << samples << " samples (" << audio_secs << " seconds)" << std::endl;
+
+    struct { const char* name; double secs; } stage[] =
+    {
+        { "Z80 Code", time_z80 },
+        { "YM2151  ", time_ym  },
+        { "SegaPCM ", time_pcm },
+        { "Mixer   ", time_mix },
+    };
+
+    for (int i = 0; i < 4; i++)
+    {
+        std::cout << stage[i].name << ": " << stage[i].secs << " s";
+        if (stage[i].secs > 0)
+            std::cout << ", " << (uint64_t) (samples / stage[i].secs) << " samples/sec"
+                      << ", " << (audio_secs / stage[i].secs) << "x real-time";
+        std::cout << std::endl;
+    }
+
+    const double total = time_z80 + time_ym + time_pcm + time_mix;
+    if (total > 0)
+        std::cout << "Total   : " << total << " s, " << (audio_secs / total) << "x real-time" << std::endl;
+}
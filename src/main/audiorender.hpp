@@ -0,0 +1,55 @@
+/***************************************************************************
+    Offline Audio Renderer.
+
+    Runs the ported Z80 sound program, YM2151 and Sega PCM emulation without
+    an audio device, and writes the mixed output to a WAV file as fast as
+    the CPU allows.
+
+    The sound commands either come from a built in script, which plays
+    every music track and sound effect, or from a session recorded with
+    -record_audio. The time spent in each chip is reported, which gives a
+    fixed workload for benchmarking the sound code.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#pragma once
+
+#include <fstream>
+#include <string>
+#include "stdint.hpp"
+#include "hwaudio/mixer.hpp"
+
+class AudioRender
+{
+public:
+    AudioRender();
+    ~AudioRender();
+
+    // Render all music tracks and sound effects
+    bool render_script(const std::string& wav_filename);
+
+    // Render a session recorded with OSoundInt::record_start
+    bool render_session(const std::string& log_filename, const std::string& wav_filename);
+
+private:
+    // Frame rate the sound code is ticked at when rendering a script
+    static const int SCRIPT_FPS = 60;
+
+    std::ofstream wav;
+    uint32_t data_bytes;
+
+    Mixer mixer;
+    int16_t* mix_buffer;
+
+    // Time spent (seconds) and samples output
+    double time_z80, time_ym, time_pcm, time_mix;
+    uint64_t samples;
+
+    bool begin(const std::string& wav_filename, int fps);
+    void frame();
+    void frames(int count);
+    bool end();
+    void report();
+};
@@ -12,6 +12,7 @@
 #include "engine/outrun.hpp"
 #include "engine/audio/osound.hpp"
 #include "engine/audio/osoundint.hpp"
+#include "savestate.hpp"
 
 OSoundInt osoundint;
 OSound osound;
@@ -36,7 +37,24 @@ void OSoundInt::init()
         ym = new YM2151(0.5f, SOUND_CLOCK);
 
     pcm->init(config.sound.rate, config.fps);
-    ym->init(config.sound.rate, config.fps);
+
+    // The YM2151 can be synthesised at a lower rate and resampled to the output rate
+    int ym_rate = config.sound.rate;
+    if (config.sound.fm_divider > 0)
+        ym_rate = (SOUND_CLOCK / 64) / config.sound.fm_divider;
+    else if (config.sound.fm_rate > 0)
+        ym_rate = config.sound.fm_rate;
+
+    // Use a whole number of samples per frame, so each frame resamples exactly
+    if (ym_rate != config.sound.rate)
+        ym_rate = ((ym_rate + (config.fps / 2)) / config.fps) * config.fps;
+
+    ym->init(ym_rate, config.fps);
+    ym->set_output_rate(config.sound.rate, config.sound.fm_quality);
+
+    // Per chip volume, applied when the chip outputs are mixed
+    pcm->set_volume(config.sound.vol_pcm);
+    ym->set_volume(config.sound.vol_ym);
 
     reset();
 
@@ -64,6 +82,9 @@ void OSoundInt::reset()
 
 void OSoundInt::tick()
 {
+    if (record_file.is_open())
+        record_frame();
+
     // The audio code is updated 125 times per second
     audio_ticks += (125.0 / config.fps);
 
@@ -156,6 +177,9 @@ void OSoundInt::queue_sound(uint8_t snd)
 
 void OSoundInt::add_to_queue(uint8_t snd)
 {
+    if (record_file.is_open() && !outrun.speculative)
+        record_cmds.push_back(snd);
+
     // Add sound to the tail end of the queue
     queue[sound_tail] = snd;
     sound_tail = (sound_tail + 1) & QUEUE_LENGTH;
@@ -166,4 +190,53 @@ void OSoundInt::queue_clear()
 {
     sound_tail = 0;
     sounds_queued = 0;
-}
\ No newline at end of file
+}
+
+// ----------------------------------------------------------------------------
+// Sound Recording
+//
+// Format: "CBSR", version, fps. Then per frame: number of commands queued,
+// the commands, and the 8 bytes of engine data.
+// ----------------------------------------------------------------------------
+
+const static uint8_t RECORD_VERSION = 1;
+
+bool OSoundInt::record_start(const char* filename)
+{
+    record_stop();
+    record_file.open(filename, std::ios::out | std::ios::binary);
+    if (!record_file)
+        return false;
+
+    const char header[6] = { 'C', 'B', 'S', 'R', (char) RECORD_VERSION, (char) config.fps };
+    record_file.write(header, sizeof(header));
+    record_cmds.clear();
+    return true;
+}
+
+void OSoundInt::add_state(SaveState& state)
+{
+    state.add(has_booted);
+    state.add(engine_data);
+    state.add(sound_counter);
+    state.add(queue);
+    state.add(sounds_queued);
+    state.add(sound_head);
+    state.add(sound_tail);
+}
+
+void OSoundInt::record_stop()
+{
+    if (record_file.is_open())
+        record_file.close();
+}
+
+void OSoundInt::record_frame()
+{
+    // Commands beyond 255 in a single frame would overflow the queue anyway
+    uint8_t count = record_cmds.size() > 0xFF ? 0xFF : (uint8_t) record_cmds.size();
+    record_file.put((char) count);
+    record_file.write((const char*) record_cmds.data(), count);
+    record_file.write((const char*) engine_data, sizeof(engine_data));
+    record_cmds.clear();
+}
@@ -11,10 +11,14 @@
 
 #pragma once
 
+#include <fstream>
+#include <vector>
 #include "hwaudio/segapcm.hpp"
 #include "hwaudio/ym2151.hpp"
 #include "engine/audio/commands.hpp"
 
+class SaveState;
+
 class OSoundInt
 {
 public:
@@ -51,6 +55,13 @@ public:
     void queue_sound(uint8_t snd);
     void queue_clear();
 
+    // Record sound commands and engine data each frame, for offline rendering
+    bool record_start(const char* filename);
+    void record_stop();
+
+    // Sound queue and engine data, as written by the main CPU
+    void add_state(SaveState& state);
+
 private:
     // 4 MHz
     static const uint32_t SOUND_CLOCK = 4000000;
@@ -74,7 +85,12 @@ private:
     // Positions in the queue
     uint8_t sound_head, sound_tail;
 
+    // Sound recording
+    std::ofstream record_file;
+    std::vector<uint8_t> record_cmds;
+
     void add_to_queue(uint8_t snd);
+    void record_frame();
 };
 
 extern OSoundInt osoundint;
\ No newline at end of file
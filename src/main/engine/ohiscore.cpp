@@ -241,7 +241,7 @@ void OHiScore::check_name_entry()
         do_input(score_adr);
         
         // Save new score info
-        if (state == STATE_DONE)
+        if (state == STATE_DONE && !outrun.speculative)
             config.save_scores(outrun.cannonball_mode == Outrun::MODE_ORIGINAL);
     }
 }
@@ -76,9 +76,14 @@ void OHud::clear_timetrial_text()
     blit_text_new(16, 7, "            ");
 }
 
-void OHud::draw_fps_counter(int16_t fps)
+void OHud::draw_fps_counter(int16_t fps, int16_t skipped)
 {
     std::string str = "FPS " + Utils::to_string(fps);
+    if (skipped)
+        str += " S" + Utils::to_string(skipped);
+
+    // Pad to clear a previous, longer, counter
+    str.resize(10, ' ');
     blit_text_new(30, 0, str.c_str());
 }
 
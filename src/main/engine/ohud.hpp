@@ -34,7 +34,7 @@ public:
     ~OHud(void);
 
     void draw_main_hud();
-    void draw_fps_counter(int16_t);
+    void draw_fps_counter(int16_t fps, int16_t skipped);
     void clear_timetrial_text();
     void do_mini_map();
     void draw_timer1(uint16_t);
@@ -12,6 +12,7 @@
 ***************************************************************************/
 
 #include "trackloader.hpp"
+#include "utils.hpp"
 
 #include "engine/oanimseq.hpp"
 #include "engine/obonus.hpp"
@@ -135,6 +136,9 @@ void OInitEngine::setup_stage1()
 void OInitEngine::init_road_seg_master()
 {
     trackloader.init_track(oroad.stage_lookup_off);
+
+    if (config.data.memory_report && !outrun.speculative)
+        Utils::report_rss("stage load");
 }
 
 //
@@ -822,7 +822,7 @@ void OOutputs::done()
 // This is the equivalent to writing to register 0x140003
 void OOutputs::motor_output(uint8_t cmd)
 {
-    if (cmd == MOTOR_OFF || cmd == MOTOR_CENTRE)
+    if (cmd == MOTOR_OFF || cmd == MOTOR_CENTRE || outrun.speculative)
         return;
 
     int8_t force = 0;
@@ -18,8 +18,13 @@
     See license.txt for more details.
 ***************************************************************************/
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 #include "stdint.hpp"
 #include "globals.hpp"
+#include "realtime.hpp"
 #include "roms.hpp"
 #include "trackloader.hpp"
 
@@ -30,6 +35,14 @@
 #include "engine/oroad.hpp"
 #include "engine/ostats.hpp"
 
+// Road thread. Kept outside ORoad, so the road state remains plain data that can be copied.
+// Declared before oroad, so they are destroyed after it.
+static std::thread output_thread;
+static std::mutex output_mutex;
+static std::condition_variable output_cond;
+static bool output_pending = false;
+static bool output_quit    = false;
+
 ORoad oroad;
 
 ORoad::ORoad(void)
@@ -39,10 +52,32 @@ ORoad::ORoad(void)
 
 ORoad::~ORoad(void)
 {
+    stop_thread();
 }
 
-void ORoad::tick()
+// Stop the road thread. It is started again by the next parallel tick.
+void ORoad::stop_thread()
 {
+    if (!output_thread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        output_quit = true;
+    }
+    output_cond.notify_all();
+    output_thread.join();
+
+    output_pending = false;
+    output_quit    = false;
+}
+
+// parallel: Run the output stage on the road thread. Call sync() before the road RAM is used.
+void ORoad::tick(bool parallel)
+{
+    // Output from the last tick must be complete before the road values move on
+    sync();
+
     // Enhancement: Adjust View
     if (horizon_target != horizon_offset)
     {
@@ -61,6 +96,49 @@ void ORoad::tick()
     }
 
     do_road();
+
+    output_pos_fine = pos_fine;
+
+    if (!parallel)
+    {
+        output_road();
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(output_mutex);
+    if (!output_thread.joinable())
+        output_thread = std::thread(&ORoad::output_loop, this);
+    output_pending = true;
+    output_cond.notify_one();
+}
+
+// Wait for the road thread to finish the output stage
+void ORoad::sync()
+{
+    std::unique_lock<std::mutex> lock(output_mutex);
+    output_cond.wait(lock, []() { return !output_pending; });
+}
+
+void ORoad::output_loop()
+{
+    // Don't share the main thread's core. Keep its priority, as it waits for this thread in sync().
+    realtime::reset_thread("road", true);
+
+    std::unique_lock<std::mutex> lock(output_mutex);
+
+    for (;;)
+    {
+        output_cond.wait(lock, []() { return output_pending || output_quit; });
+        if (output_quit)
+            return;
+
+        lock.unlock();
+        output_road();
+        lock.lock();
+
+        output_pending = false;
+        output_cond.notify_all();
+    }
 }
 
 // Helper function
@@ -197,6 +275,12 @@ void ORoad::do_road()
     setup_road_y();
     set_road_y();
     set_horizon_y();
+}
+
+// Output stage. Writes the working road data to road RAM.
+// Nothing that the main CPU reads during the frame is written here.
+void ORoad::output_road()
+{
     do_road_data();
     blit_roads();
     output_hscroll(&road0_h[0], HW_HSCROLL_TABLE0);
@@ -1598,7 +1682,7 @@ void ORoad::output_hscroll(int16_t* src, uint32_t dst)
 void ORoad::copy_bg_color()
 {
     // Scroll stripe data over road based on fine position
-    uint32_t pos_fine_copy = (pos_fine & 0x1F) << 10;
+    uint32_t pos_fine_copy = (output_pos_fine & 0x1F) << 10;
     uint32_t src = ROAD_BGCOLOR + pos_fine_copy;
     uint32_t dst = HW_BGCOLOR;
 
@@ -157,7 +157,9 @@ public:
 	ORoad();
 	~ORoad();
 	void init();
-	void tick();
+	void tick(bool parallel = false);
+    void sync();
+    void stop_thread();
     uint8_t get_view_mode();
     int16_t get_road_y(uint16_t);
     void set_view_mode(uint8_t, bool snap = false);
@@ -166,6 +168,16 @@ private:
     // Enhancement: View Mode
     uint8_t view_mode;
 
+    // Parallel Road CPU.
+    // The output stage (road data, blits to road RAM and background colour) runs on its own thread,
+    // as the original SUB CPU would, while the main CPU carries on with the vertical interrupt.
+    //
+    // pos_fine, latched when the output stage starts. The main CPU updates pos_fine in the meantime.
+    uint16_t output_pos_fine;
+
+    void output_road();
+    void output_loop();
+
     // Enhancement: Target Horizon Adjust
     int16_t horizon_target;
 
@@ -528,6 +528,7 @@ void OSprites::blit_sprites()
     for (uint16_t i = 0; i <= sprite_count; i++)
     {
         uint16_t* data = sprite_entries[i].data;
+        const uint32_t entry_addr = dst_addr;
 
         // Write twelve bytes
         video.write_sprite16(&dst_addr, data[0]);
@@ -538,6 +539,9 @@ void OSprites::blit_sprites()
         video.write_sprite16(&dst_addr, data[5]);
         video.write_sprite16(&dst_addr, data[6]);
 
+        // Tag with the jump table entry it came from
+        video.write_sprite_tag(entry_addr, sprite_entries[i].scratch + 1);
+
         // Allign on correct boundary
         dst_addr += 2;
     }
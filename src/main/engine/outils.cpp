@@ -9,6 +9,7 @@
 ***************************************************************************/
 #include <cstdlib> 
 #include "engine/outils.hpp"
+#include "savestate.hpp"
 #include "engine/ostats.hpp"
 
 outils::outils(void)
@@ -34,6 +35,11 @@ void outils::reset_random_seed()
     rnd_seed = 0;
 }
 
+void outils::add_state(SaveState& state)
+{
+    state.add(rnd_seed);
+}
+
 uint32_t outils::random()
 {
 	// New seed value
@@ -12,6 +12,8 @@
 
 #include "stdint.hpp"
 
+class SaveState;
+
 class outils
 {
 public:
@@ -22,6 +24,7 @@ public:
 
     static void reset_random_seed();
 	static uint32_t random();
+    static void add_state(SaveState& state);
 	static int32_t isqrt(int32_t);
     static uint16_t convert16_dechex(uint16_t);
     static uint32_t bcd_add(uint32_t, uint32_t);
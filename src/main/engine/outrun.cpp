@@ -30,6 +30,7 @@
 #include "engine/otiles.hpp"
 #include "engine/otraffic.hpp"
 #include "engine/outils.hpp"
+#include "savestate.hpp"
 
 Outrun outrun;
 
@@ -57,6 +58,7 @@ Outrun outrun;
 Outrun::Outrun()
 {
     outputs = new OOutputs();
+    speculative = false;
 }
 
 Outrun::~Outrun()
@@ -90,6 +92,37 @@ void Outrun::init()
     boot();
 }
 
+// Complete engine state: the objects ported from the main and sub CPU programs, plus the
+// data they keep elsewhere. Video and sound hardware are added separately.
+void Outrun::add_state(SaveState& state)
+{
+    state.add(*this);
+    state.add(*outputs);
+    state.add(oanimseq);
+    state.add(oattractai);
+    state.add(obonus);
+    state.add(ocrash);
+    state.add(oferrari);
+    state.add(ohiscore);
+    state.add(ohud);
+    state.add(oinitengine);
+    state.add(oinputs);
+    state.add(olevelobjs);
+    state.add(ologo);
+    state.add(omap);
+    state.add(omusic);
+    state.add(opalette);
+    state.add(oroad);
+    state.add(osmoke);
+    state.add(osprites);
+    state.add(ostats);
+    state.add(otiles);
+    state.add(otraffic);
+    osoundint.add_state(state);
+    trackloader.add_state(state);
+    outils::add_state(state);
+}
+
 void Outrun::boot()
 {
     game_state = config.engine.layout_debug ? GS_INIT_GAME : GS_INIT;
@@ -129,6 +162,9 @@ void Outrun::tick(bool tick_frame)
     // The timing here isn't perfect, as normally the road CPU would run in parallel with the main CPU.
     // We can potentially hack this by calling the road CPU twice.
     // Most noticeable with clipping sprites on hills.
+    //
+    // With engine.road_thread, the road CPU's output stage does run in parallel with the vertical interrupt.
+    const bool road_thread = config.engine.road_thread;
       
     // 30 FPS 
     // Updates Game Logic 1/2 frames
@@ -136,7 +172,7 @@ void Outrun::tick(bool tick_frame)
     if (config.fps == 30 && config.tick_fps == 30)
     {
         jump_table();
-        oroad.tick();
+        oroad.tick(road_thread);
         vint();
         vint();
     }
@@ -148,7 +184,7 @@ void Outrun::tick(bool tick_frame)
         if (tick_frame)
         {
             jump_table();
-            oroad.tick();
+            oroad.tick(road_thread);
         }
         vint();
     }
@@ -158,7 +194,7 @@ void Outrun::tick(bool tick_frame)
     else
     {
         jump_table();
-        oroad.tick();
+        oroad.tick(road_thread);
         vint();
     }
 
@@ -172,7 +208,10 @@ void Outrun::tick(bool tick_frame)
 
     // Draw FPS
     if (config.video.fps_count)
-        ohud.draw_fps_counter(cannonball::fps_counter);
+        ohud.draw_fps_counter(cannonball::fps_counter, cannonball::fps_skipped);
+
+    // Road RAM is complete for this frame
+    oroad.sync();
 }
 
 // Vertical Interrupt
@@ -935,6 +974,9 @@ void Outrun::select_course(bool jap, bool prototype)
         roms.rom0p = &roms.rom0;
         roms.rom1p = &roms.rom1;
 
+        if (config.data.low_memory)
+            roms.unload_japanese_roms();
+
         // Main CPU
         adr.tiles_def_lookup      = TILES_DEF_LOOKUP;
         adr.tiles_table           = TILES_TABLE;
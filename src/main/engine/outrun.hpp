@@ -175,6 +175,7 @@ struct adr_t
 };
 
 class OOutputs;
+class SaveState;
 
 class Outrun
 {
@@ -183,6 +184,10 @@ public:
 
     bool freeze_timer;
 
+    // Run-ahead: The frame is simulated, and will be rewound. Effects outside the engine
+    // state (saving scores, console output, force feedback and sound recording) are skipped.
+    bool speculative;
+
     // CannonBall Game Mode
     uint8_t cannonball_mode;
 
@@ -214,6 +219,7 @@ public:
 	Outrun();
 	~Outrun();
 	void init();
+    void add_state(SaveState& state);
     void boot();
 	void tick(bool tick_frame);
 	void vint();
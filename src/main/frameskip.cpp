@@ -0,0 +1,103 @@
+/***************************************************************************
+    Adaptive Frame Skipping.
+
+    When the machine can't keep up, skips drawing some frames, while the
+    game logic and sound still run for every frame. This keeps the game
+    speed and sound correct on slower hardware.
+
+    The skip level is the number of frames drawn out of every CYCLE
+    frames that are skipped, spread evenly. It is raised as soon as the
+    game runs slow, and lowered again only after a period running at full
+    speed. Each failed attempt to lower it doubles the period, so the
+    level doesn't oscillate.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include "frameskip.hpp"
+
+const double FrameSkip::BEHIND = 1.03;
+
+FrameSkip::FrameSkip()
+{
+    init(0);
+}
+
+FrameSkip::~FrameSkip()
+{
+}
+
+void FrameSkip::init(int max_level)
+{
+    if (max_level < 0)              max_level = 0;
+    else if (max_level > CYCLE - 1) max_level = CYCLE - 1;
+
+    this->max_level = max_level;
+    level           = 0;
+    pattern         = 0;
+    window_frames   = 0;
+    window_period   = 0;
+    window_elapsed  = 0;
+    stable          = 0;
+    stable_needed   = STABLE_MIN;
+    probing         = false;
+}
+
+bool FrameSkip::skip_next()
+{
+    if (level == 0)
+        return false;
+
+    // Spread the skipped frames evenly through the cycle
+    pattern += level;
+    if (pattern >= CYCLE)
+    {
+        pattern -= CYCLE;
+        return true;
+    }
+    return false;
+}
+
+void FrameSkip::frame_done(double period_ms, double elapsed_ms)
+{
+    if (max_level == 0)
+        return;
+
+    window_period  += period_ms;
+    window_elapsed += elapsed_ms;
+    if (++window_frames < WINDOW)
+        return;
+
+    const bool behind = window_elapsed > window_period * BEHIND;
+    window_frames  = 0;
+    window_period  = 0;
+    window_elapsed = 0;
+
+    if (behind)
+    {
+        // The last attempt to lower the level failed: wait longer before the next
+        if (probing && stable_needed < STABLE_MAX)
+            stable_needed <<= 1;
+
+        if (level < max_level)
+            level++;
+
+        stable  = 0;
+        probing = false;
+    }
+    else
+    {
+        // The lower level is sustainable
+        if (probing)
+            stable_needed = STABLE_MIN;
+        probing = false;
+
+        if (level > 0 && ++stable >= stable_needed)
+        {
+            level--;
+            stable  = 0;
+            probing = true;
+        }
+    }
+}
@@ -0,0 +1,72 @@
+/***************************************************************************
+    Adaptive Frame Skipping.
+
+    When the machine can't keep up, skips drawing some frames, while the
+    game logic and sound still run for every frame. This keeps the game
+    speed and sound correct on slower hardware.
+
+    The skip level is the number of frames drawn out of every CYCLE
+    frames that are skipped, spread evenly. It is raised as soon as the
+    game runs slow, and lowered again only after a period running at full
+    speed. Each failed attempt to lower it doubles the period, so the
+    level doesn't oscillate.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#pragma once
+
+#include "stdint.hpp"
+
+class FrameSkip
+{
+public:
+    // Skip level is out of this many frames
+    const static int CYCLE = 8;
+
+    FrameSkip();
+    ~FrameSkip();
+
+    // max_level: Most frames to skip in each CYCLE frames (0 = Off)
+    void init(int max_level);
+
+    // Whether to skip drawing the next frame. Call once per frame.
+    bool skip_next();
+
+    // A frame has ended.
+    // period_ms:  Time the frame should have taken.
+    // elapsed_ms: Time it actually took.
+    void frame_done(double period_ms, double elapsed_ms);
+
+    int get_level() const { return level; }
+
+private:
+    // Frames to measure the game speed over
+    const static int WINDOW = 30;
+
+    // Running slower than this is behind (1.03 = 3% slow)
+    const static double BEHIND;
+
+    // Windows at full speed before trying a lower level, initially and at most
+    const static int STABLE_MIN = 4;
+    const static int STABLE_MAX = 64;
+
+    int max_level;
+    int level;
+
+    // Position in the skip pattern
+    int pattern;
+
+    // Current measurement window
+    int window_frames;
+    double window_period;
+    double window_elapsed;
+
+    // Windows at full speed since the level last changed, and the number needed to lower it
+    int stable;
+    int stable_needed;
+
+    // Level was just lowered: the next window decides whether it can be kept
+    bool probing;
+};
@@ -14,9 +14,11 @@
 // Boost string prediction
 #include <boost/algorithm/string/predicate.hpp>
 #include <iostream>
+#include <sstream>
 
 #include "main.hpp"
 #include "config.hpp"
+#include "xmlsnapshot.hpp"
 #include "globals.hpp"
 #include "../utils.hpp"
 
@@ -69,6 +71,28 @@ void Config::set_config_file(const std::string& file)
 using boost::property_tree::ptree;
 ptree pt_config;
 
+// Serialize a property tree to XML in memory, for the save queue
+static std::string to_xml(const ptree& pt)
+{
+    std::ostringstream out;
+    write_xml(out, pt, xml_writer_settings('\t', 1)); // Tab space 1
+    return out.str();
+}
+
+// Read an XML file, using the binary snapshot from a previous run if the XML is unchanged.
+// Throws on error, as read_xml does.
+static void read_xml_snapshot(const std::string& filename, ptree& pt, SaveQueue& queue)
+{
+    if (XmlSnapshot::load(filename, pt))
+        return;
+
+    read_xml(filename, pt, boost::property_tree::xml_parser::trim_whitespace);
+
+    std::string snapshot;
+    if (XmlSnapshot::build(filename, pt, snapshot))
+        queue.write(XmlSnapshot::filename(filename), snapshot);
+}
+
 void Config::load()
 {
     // Load XML file and put its contents in property tree. 
@@ -77,7 +101,7 @@ void Config::load()
     // is thrown.
     try
     {
-        read_xml(data.cfg_file, pt_config, boost::property_tree::xml_parser::trim_whitespace);
+        read_xml_snapshot(data.cfg_file, pt_config, save_queue);
     }
     catch (std::exception &e)
     {
@@ -91,6 +115,10 @@ void Config::load()
     data.res_path         = pt_config.get("data.respath", "res/");   // Path to ROMs
     data.save_path        = pt_config.get("data.savepath", "./");    // Path to Save Data
     data.crc32            = pt_config.get("data.crc32", 1);
+    data.video_cache      = pt_config.get("data.video_cache", 1);
+    data.shared_assets    = pt_config.get("data.shared_assets", 0);
+    data.low_memory       = pt_config.get("data.low_memory", 0);
+    data.memory_report    = pt_config.get("data.memory_report", 0);
 
     data.file_scores      = data.save_path + "hiscores.xml";
     data.file_scores_jap  = data.save_path + "hiscores_jap.xml";
@@ -98,6 +126,8 @@ void Config::load()
     data.file_ttrial_jap  = data.save_path + "hiscores_timetrial_jap.xml";
     data.file_cont        = data.save_path + "hiscores_continuous.xml";
     data.file_cont_jap    = data.save_path + "hiscores_continuous_jap.xml";
+    data.file_rom_index   = data.save_path + "romindex.txt";
+    data.file_video_cache = data.save_path + "video.cache";
 
     // ------------------------------------------------------------------------
     // Menu Settings
@@ -120,6 +150,20 @@ void Config::load()
     video.filtering  = pt_config.get("video.filtering",          0); // Open GL Filtering Mode
     video.vsync      = pt_config.get("video.vsync",              1); // Use V-Sync where available (e.g. Open GL)
     video.shadow     = pt_config.get("video.shadow",             0); // Shadow Settings
+    video.pacing_spin   = pt_config.get("video.pacing.spin",       1500); // Frame pacing
+    video.pacing_late   = pt_config.get("video.pacing.late_input", 0);
+    video.pacing_margin = pt_config.get("video.pacing.margin",     2000);
+    video.pacing_stats  = pt_config.get("video.pacing.stats",      0);
+    video.pipeline      = pt_config.get("video.pipeline",          1); // Render on a separate thread
+    video.frameskip     = pt_config.get("video.frameskip",         0); // Adaptive frame skipping
+    video.refresh       = pt_config.get("video.refresh.rate",      0); // Display refresh independent of the game
+    video.interpolate   = pt_config.get("video.refresh.interpolate", 1);
+
+    if (video.refresh < 0) video.refresh = 0;
+
+    // Low memory: Use ROMs and graphics in place from the cache. Hi-res is disabled by Video::set_video_mode()
+    if (data.low_memory)
+        data.shared_assets = 1;
 
     // ------------------------------------------------------------------------
     // Sound Settings
@@ -130,6 +174,29 @@ void Config::load()
     sound.preview     = pt_config.get("sound.preview",     1);
     sound.fix_samples = pt_config.get("sound.fix_samples", 1);
     sound.music_timer = pt_config.get("sound.music_timer", 0);
+    sound.vol_master  = pt_config.get("sound.mixer.master", 100);
+    sound.vol_ym      = pt_config.get("sound.mixer.ym",     100);
+    sound.vol_pcm     = pt_config.get("sound.mixer.pcm",    100);
+    sound.vol_wav     = pt_config.get("sound.mixer.wav",    100);
+    sound.period      = pt_config.get("sound.latency.period",   1024);
+    sound.delay       = pt_config.get("sound.latency.delay",    20);
+    sound.buffer      = pt_config.get("sound.latency.buffer",   5);
+    sound.adaptive    = pt_config.get("sound.latency.adaptive", 0);
+    sound.stats       = pt_config.get("sound.latency.stats",    0);
+    sound.fm_rate     = pt_config.get("sound.synth.fm_rate",    0);
+    sound.fm_divider  = pt_config.get("sound.synth.fm_divider", 0);
+    sound.fm_quality  = pt_config.get("sound.synth.quality",    1);
+
+    // Audio devices expect a power of 2 period
+    int period = 64;
+    while (period < sound.period && period < 8192)
+        period <<= 1;
+    sound.period = period;
+
+    if (sound.delay < 0)        sound.delay = 0;
+    else if (sound.delay > 200) sound.delay = 200;
+    if (sound.buffer < 2)       sound.buffer = 2;
+    else if (sound.buffer > 16) sound.buffer = 16;
 
     // Custom Music. Search for enabled custom tracks
     for (int i = 0;; i++)
@@ -165,6 +232,16 @@ void Config::load()
     smartypi.ouputs  = pt_config.get("smartypi.outputs", 1);
     smartypi.cabinet = pt_config.get("smartypi.cabinet", 1);
 
+    // ------------------------------------------------------------------------
+    // Real-Time Scheduling
+    // ------------------------------------------------------------------------
+    realtime.policy         = pt_config.get("realtime.policy",         1);
+    realtime.main_core      = pt_config.get("realtime.main.core",     -1);
+    realtime.main_priority  = pt_config.get("realtime.main.priority",  0);
+    realtime.audio_core     = pt_config.get("realtime.audio.core",    -1);
+    realtime.audio_priority = pt_config.get("realtime.audio.priority", 0);
+    realtime.mlock          = pt_config.get("realtime.mlock",          0);
+
     // ------------------------------------------------------------------------
     // Controls
     // ------------------------------------------------------------------------
@@ -246,6 +323,14 @@ void Config::load()
     engine.bumper          = pt_config.get("engine.bumper", 0);
     engine.turbo           = pt_config.get("engine.turbo", 0);
     engine.car_pal         = pt_config.get("engine.car_color", 0);
+    engine.road_thread     = pt_config.get("engine.road_thread", 0) != 0;
+    engine.run_ahead       = pt_config.get("engine.run_ahead", 0);
+
+    if (engine.run_ahead < 0) engine.run_ahead = 0;
+    else if (engine.run_ahead > 3) engine.run_ahead = 3;
+
+    engine.fast_forward    = pt_config.get("engine.fast_forward", 8);
+    if (engine.fast_forward < 0) engine.fast_forward = 0;
 
     if (!engine.hiscore_timer)
         engine.hiscore_timer = HIGHSCORE_TIMER;
@@ -274,7 +359,8 @@ bool Config::save()
     pt_config.put("video.scanlines",          video.scanlines);
     pt_config.put("video.fps",                video.fps);
     pt_config.put("video.widescreen",         video.widescreen);
-    pt_config.put("video.hires",              video.hires);
+    if (!data.low_memory) // Hi-res is forced off in low memory mode: keep the saved setting
+        pt_config.put("video.hires",          video.hires);
 
     pt_config.put("sound.enable",             sound.enabled);
     pt_config.put("sound.advertise",          sound.advertise);
@@ -354,6 +440,8 @@ bool Config::save()
 
 void Config::load_scores(bool original_mode)
 {
+    flush_scores(); // Read back any scores still being written
+
     std::string filename;
 
     if (original_mode)
@@ -366,7 +454,7 @@ void Config::load_scores(bool original_mode)
 
     try
     {
-        read_xml(filename , pt, boost::property_tree::xml_parser::trim_whitespace);
+        read_xml_snapshot(filename, pt, save_queue);
     }
     catch (std::exception &e)
     {
@@ -424,7 +512,7 @@ void Config::save_scores(bool original_mode)
     
     try
     {
-        write_xml(filename, pt, std::locale(), xml_writer_settings('\t', 1)); // Tab space 1
+        save_queue.write(filename, to_xml(pt));
     }
     catch (std::exception &e)
     {
@@ -437,12 +525,14 @@ void Config::load_tiletrial_scores()
     // Counter value that represents 1m 15s 0ms
     static const uint16_t COUNTER_1M_15 = 0x11D0;
 
+    flush_scores(); // Read back any scores still being written
+
     // Create empty property tree object
     ptree pt;
 
     try
     {
-        read_xml(engine.jap ? config.data.file_ttrial_jap : config.data.file_ttrial, pt, boost::property_tree::xml_parser::trim_whitespace);
+        read_xml_snapshot(engine.jap ? config.data.file_ttrial_jap : config.data.file_ttrial, pt, save_queue);
     }
     catch (std::exception &e)
     {
@@ -473,7 +563,7 @@ void Config::save_tiletrial_scores()
 
     try
     {
-        write_xml(engine.jap ? config.data.file_ttrial_jap : config.data.file_ttrial, pt, std::locale(), xml_writer_settings('\t', 1)); // Tab space 1
+        save_queue.write(engine.jap ? config.data.file_ttrial_jap : config.data.file_ttrial, to_xml(pt));
     }
     catch (std::exception &e)
     {
@@ -486,6 +576,9 @@ bool Config::clear_scores()
     // Init Default Hiscores
     ohiscore.init_def_scores();
 
+    // Don't let a queued save recreate a file after it is removed
+    flush_scores();
+
     int clear = 0;
 
     // Remove XML files if they exist
@@ -496,10 +589,21 @@ bool Config::clear_scores()
     clear += remove(data.file_cont.c_str());
     clear += remove(data.file_cont_jap.c_str());
 
+    // Remove snapshots of the XML files
+    const std::string* files[] = { &data.file_scores, &data.file_scores_jap, &data.file_ttrial, &data.file_ttrial_jap, &data.file_cont, &data.file_cont_jap };
+    for (int i = 0; i < 6; i++)
+        remove(XmlSnapshot::filename(*files[i]).c_str());
+
     // remove returns 0 on success
     return clear == 6;
 }
 
+// Wait for queued score files to be written
+void Config::flush_scores()
+{
+    save_queue.flush();
+}
+
 void Config::set_fps(int fps)
 {
     video.fps = fps;
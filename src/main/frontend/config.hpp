@@ -14,6 +14,7 @@
 #include <string>
 #include <vector>
 #include "stdint.hpp"
+#include "frontend/savequeue.hpp"
 
 struct data_settings_t
 {
@@ -22,6 +23,10 @@ struct data_settings_t
     std::string save_path;
     std::string cfg_file;
     int crc32;
+    int video_cache;
+    int shared_assets;
+    int low_memory;
+    int memory_report;
 
     std::string file_scores;            // Arcade Hi-Scores (World & Japanese)
     std::string file_scores_jap;
@@ -29,6 +34,8 @@ struct data_settings_t
     std::string file_ttrial_jap;
     std::string file_cont;              // Continous Mode Hi-Scores
     std::string file_cont_jap;
+    std::string file_rom_index;         // Cached CRC32 values of files in ROM directory
+    std::string file_video_cache;       // Cached decoded tiles, sprites and road
 };
 
 struct music_t
@@ -73,6 +80,14 @@ struct video_settings_t
     int filtering;
     int vsync;
     int shadow;
+    int pacing_spin;    // Spin for the last part of each frame (microseconds)
+    int pacing_stats;   // Print frame pacing statistics every second
+    int pacing_late;    // Read input as late as possible before each frame
+    int pacing_margin;  // Time to leave spare before each buffer swap, when reading input late (microseconds)
+    int pipeline;       // Frames in flight between composition and presentation (1 = Off)
+    int frameskip;      // Most frames to skip drawing in every 8, when running slow (0 = Off)
+    int refresh;        // Display refresh rate, independent of the game logic (Hz, 0 = Match the game)
+    int interpolate;    // Blend between logic frames, when the display refresh is independent
 };
 
 struct sound_settings_t
@@ -83,6 +98,18 @@ struct sound_settings_t
     int preview;
     int fix_samples;
     int music_timer;
+    int vol_master;     // Mixer Levels (Percentage: 0 = Off, 100 = Normal, 200 = Max)
+    int vol_ym;
+    int vol_pcm;
+    int vol_wav;
+    int period;         // Audio Latency: Samples per device callback
+    int delay;          // Target delay (ms)
+    int buffer;         // Buffer size in device periods
+    int adaptive;       // Reduce delay until underruns occur
+    int stats;          // Print latency statistics
+    int fm_rate;        // YM2151 synthesis rate (0 = Output rate)
+    int fm_divider;     // YM2151 synthesis at native rate divided by this (0 = Off)
+    int fm_quality;     // Resampler quality (0 - 2)
     std::vector <music_t> music;
 };
 
@@ -118,6 +145,16 @@ struct smartypi_settings_t
     int cabinet;      // Cabinet Type
 };
 
+struct realtime_settings_t
+{
+    int policy;         // Real-time scheduling policy: 1 = FIFO, 2 = Round Robin
+    int main_core;      // Core for the main (emulation) thread (-1 = Any)
+    int main_priority;  // Real-time priority for the main thread (0 = Normal scheduling)
+    int audio_core;     // Core for the audio callback thread (-1 = Any)
+    int audio_priority; // Real-time priority for the audio callback thread (0 = Normal scheduling)
+    int mlock;          // Lock memory into RAM
+};
+
 struct engine_settings_t
 {
     int dip_time;
@@ -141,6 +178,9 @@ struct engine_settings_t
     bool bumper;          // Handling: Smash into other cars without spinning
     bool turbo;           // Handling: Faster Car
     int car_pal;          // Car Palette
+    bool road_thread;     // Run the road CPU output on a second core
+    int run_ahead;        // Frames to simulate ahead of the displayed frame (0 - 3)
+    int fast_forward;     // Fast-forward speed: frames run per frame drawn (0 = Uncapped)
 };
 
 class Config
@@ -154,6 +194,7 @@ public:
     engine_settings_t      engine;
     ttrial_settings_t      ttrial;
     smartypi_settings_t    smartypi;
+    realtime_settings_t    realtime;
 	
 	const static int CABINET_MOVING  = 0;
 	const static int CABINET_UPRIGHT = 1;
@@ -185,11 +226,14 @@ public:
     void load_tiletrial_scores();
     void save_tiletrial_scores();
     bool clear_scores();
+    void flush_scores();
     void set_fps(int fps);
     void inc_time();
     void inc_traffic();
    
 private:
+    // Scores and XML snapshots are written in the background, so saving never stalls the game
+    SaveQueue save_queue;
 };
 
 extern Config config;
@@ -386,7 +386,7 @@ void Menu::tick_ui()
 
     // Draw FPS
     if (config.video.fps_count)
-        ohud.draw_fps_counter(cannonball::fps_counter);
+        ohud.draw_fps_counter(cannonball::fps_counter, cannonball::fps_skipped);
 
     oroad.tick();
 }
@@ -653,7 +653,7 @@ void Menu::tick_menu()
                 config.video.widescreen ^= 1;
                 restart_video();
             }
-            else if (SELECTED(ENTRY_HIRES))
+            else if (SELECTED(ENTRY_HIRES) && !config.data.low_memory) // Unavailable in low memory mode
             {
                 config.video.hires ^= 1;
                 if (config.video.hires)
@@ -889,7 +889,7 @@ void Menu::refresh_menu()
             if (SELECTED(ENTRY_FULLSCREEN))         set_menu_text(ENTRY_FULLSCREEN, VIDEO_LABELS[config.video.mode]);
             else if (SELECTED(ENTRY_WIDESCREEN))    set_menu_text(ENTRY_WIDESCREEN, config.video.widescreen ? "ON" : "OFF");
             else if (SELECTED(ENTRY_SCALE))         set_menu_text(ENTRY_SCALE, Utils::to_string(config.video.scale) + "X");
-            else if (SELECTED(ENTRY_HIRES))         set_menu_text(ENTRY_HIRES, config.video.hires ? "ON" : "OFF");
+            else if (SELECTED(ENTRY_HIRES))         set_menu_text(ENTRY_HIRES, config.data.low_memory ? "DISABLED" : config.video.hires ? "ON" : "OFF");
             else if (SELECTED(ENTRY_FPS))           set_menu_text(ENTRY_FPS, FPS_LABELS[config.video.fps]);
             else if (SELECTED(ENTRY_SCANLINES))     set_menu_text(ENTRY_SCANLINES, config.video.scanlines ? Utils::to_string(config.video.scanlines) +"%": "OFF");
         }
@@ -1083,7 +1083,7 @@ void Menu::start_game(int mode, int settings)
     // Enhanced Settings
     if (settings == 1)
     {
-        if (!config.video.hires)
+        if (!config.video.hires && !config.data.low_memory)
         {
             if (config.video.scale > 1)
                 config.video.scale >>= 1;
@@ -1097,7 +1097,7 @@ void Menu::start_game(int mode, int settings)
 
         config.set_fps(config.video.fps = 2);
         config.video.widescreen     = 1;
-        config.video.hires          = 1;
+        config.video.hires          = config.data.low_memory ? 0 : 1;
         config.engine.level_objects = 1;
         config.engine.new_attract   = 1;
         config.engine.fix_bugs      = 1;
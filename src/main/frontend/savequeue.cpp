@@ -0,0 +1,156 @@
+/***************************************************************************
+    Write-Behind Save Queue.
+
+    Writes files on a worker thread, so the game never waits on the
+    filesystem (for example, saving scores to an SD card after name entry).
+
+    Each write replaces the file atomically: the data is written to a
+    temporary file, flushed to disk, then renamed over the original in a
+    single step. The rename is flushed to disk too. A power cut leaves
+    either the old or the new file, never a partial one.
+
+    Repeated saves of the same file are coalesced: only the latest
+    contents are written.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include <cstdio>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "savequeue.hpp"
+#include "realtime.hpp"
+
+SaveQueue::SaveQueue()
+{
+    writing = false;
+    running = false;
+}
+
+SaveQueue::~SaveQueue()
+{
+    stop();
+}
+
+void SaveQueue::write(const std::string& filename, const std::string& contents)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Worker is started on first use
+    if (!running)
+    {
+        running = true;
+        worker  = std::thread(&SaveQueue::run, this);
+    }
+
+    pending[filename] = contents;
+    wake.notify_one();
+}
+
+void SaveQueue::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this]() { return pending.empty() && !writing; });
+}
+
+void SaveQueue::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+        wake.notify_one();
+    }
+
+    if (worker.joinable())
+        worker.join();
+}
+
+void SaveQueue::run()
+{
+    realtime::reset_thread("save");
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    for (;;)
+    {
+        wake.wait(lock, [this]() { return !pending.empty() || !running; });
+
+        // Remaining writes are completed before stopping
+        if (pending.empty())
+            break;
+
+        std::string filename = pending.begin()->first;
+        std::string contents;
+        contents.swap(pending.begin()->second);
+        pending.erase(pending.begin());
+
+        writing = true;
+        lock.unlock();
+
+        if (!write_file(filename, contents))
+            std::cout << "Error saving file: " << filename << std::endl;
+
+        lock.lock();
+        writing = false;
+
+        if (pending.empty())
+            idle.notify_all();
+    }
+}
+
+bool SaveQueue::write_file(const std::string& filename, const std::string& contents)
+{
+    const std::string temp = filename + ".tmp";
+
+    FILE* f = fopen(temp.c_str(), "wb");
+    if (f == NULL)
+        return false;
+
+    bool ok = fwrite(contents.data(), 1, contents.size(), f) == contents.size();
+    ok &= fflush(f) == 0;
+
+    // Ensure the data is on disk before the rename makes it visible
+#ifdef _WIN32
+    ok &= _commit(_fileno(f)) == 0;
+#else
+    ok &= fsync(fileno(f)) == 0;
+#endif
+
+    ok &= fclose(f) == 0;
+
+    if (!ok)
+    {
+        remove(temp.c_str());
+        return false;
+    }
+
+#ifdef _WIN32
+    // rename() does not replace existing files on Windows
+    return MoveFileExA(temp.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    if (rename(temp.c_str(), filename.c_str()) != 0)
+        return false;
+
+    // The rename is an update to the directory, which must also reach the disk
+    const size_t slash = filename.find_last_of('/');
+    const std::string dir = slash == std::string::npos ? "." : slash == 0 ? "/" : filename.substr(0, slash);
+
+    const int fd = ::open(dir.c_str(), O_RDONLY);
+    if (fd == -1)
+        return false;
+
+    ok = fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+#endif
+}
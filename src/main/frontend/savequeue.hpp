@@ -0,0 +1,55 @@
+/***************************************************************************
+    Write-Behind Save Queue.
+
+    Writes files on a worker thread, so the game never waits on the
+    filesystem (for example, saving scores to an SD card after name entry).
+
+    Each write replaces the file atomically: the data is written to a
+    temporary file, flushed to disk, then renamed over the original. A
+    power cut leaves either the old or the new file, never a partial one.
+
+    Repeated saves of the same file are coalesced: only the latest
+    contents are written.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#pragma once
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class SaveQueue
+{
+public:
+    SaveQueue();
+    ~SaveQueue();
+
+    // Queue the contents of a file to be written. Replaces any pending write of the same file.
+    void write(const std::string& filename, const std::string& contents);
+
+    // Wait until all queued writes are complete
+    void flush();
+
+    // Complete queued writes and stop the worker thread
+    void stop();
+
+private:
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;   // Signalled when a write is queued, or on stop
+    std::condition_variable idle;   // Signalled when the queue is empty
+
+    // Pending writes by filename
+    std::map<std::string, std::string> pending;
+
+    bool writing;
+    bool running;
+
+    void run();
+    static bool write_file(const std::string& filename, const std::string& contents);
+};
@@ -0,0 +1,170 @@
+/***************************************************************************
+    XML Snapshots.
+
+    A compact binary copy of a property tree read from an XML file, so the
+    XML need not be parsed again on the next run.
+
+    The snapshot is tied to the modification time, size and CRC of the
+    XML file, which remains the editable source of truth. If the XML
+    changes, the snapshot is ignored and replaced. The CRC catches edits
+    that keep the size within the one second resolution of the time.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sys/stat.h>
+#include <boost/crc.hpp>
+
+#include "xmlsnapshot.hpp"
+
+using boost::property_tree::ptree;
+
+bool XmlSnapshot::stat_xml(const std::string& xml_file, int64_t& mtime, uint64_t& size)
+{
+    struct stat st;
+    if (stat(xml_file.c_str(), &st) != 0)
+        return false;
+
+    mtime = (int64_t) st.st_mtime;
+    size  = (uint64_t) st.st_size;
+    return true;
+}
+
+bool XmlSnapshot::crc_xml(const std::string& xml_file, uint32_t& crc)
+{
+    std::ifstream src(xml_file.c_str(), std::ios::in | std::ios::binary);
+    if (!src)
+        return false;
+
+    const std::string xml((std::istreambuf_iterator<char>(src)), std::istreambuf_iterator<char>());
+    boost::crc_32_type result;
+    result.process_bytes(xml.data(), xml.size());
+    crc = result.checksum();
+    return true;
+}
+
+bool XmlSnapshot::load(const std::string& xml_file, ptree& pt)
+{
+    int64_t mtime;
+    uint64_t size;
+    if (!stat_xml(xml_file, mtime, size))
+        return false;
+
+    std::ifstream src(filename(xml_file).c_str(), std::ios::in | std::ios::binary);
+    if (!src)
+        return false;
+
+    const std::string snapshot((std::istreambuf_iterator<char>(src)), std::istreambuf_iterator<char>());
+    if (snapshot.size() < sizeof(header_t))
+        return false;
+
+    header_t h;
+    memcpy(&h, snapshot.data(), sizeof(header_t));
+
+    if (memcmp(h.magic, "CBXS", 4) != 0 ||
+        h.version    != VERSION ||
+        h.byte_order != BYTE_ORDER_MARK ||
+        h.xml_mtime  != mtime ||
+        h.xml_size   != size)
+        return false;
+
+    // Only read the XML once the cheaper checks have passed
+    uint32_t crc;
+    if (!crc_xml(xml_file, crc) || h.xml_crc != crc)
+        return false;
+
+    const char* pos = snapshot.data() + sizeof(header_t);
+    const char* end = snapshot.data() + snapshot.size();
+
+    ptree tree;
+    if (!read_node(pos, end, tree) || pos != end)
+        return false;
+
+    pt.swap(tree);
+    return true;
+}
+
+bool XmlSnapshot::build(const std::string& xml_file, const ptree& pt, std::string& snapshot)
+{
+    header_t h;
+    memset(&h, 0, sizeof(header_t));
+    memcpy(h.magic, "CBXS", 4);
+    h.version    = VERSION;
+    h.byte_order = BYTE_ORDER_MARK;
+
+    if (!stat_xml(xml_file, h.xml_mtime, h.xml_size) || !crc_xml(xml_file, h.xml_crc))
+        return false;
+
+    snapshot.assign((const char*) &h, sizeof(header_t));
+    write_node(snapshot, pt);
+    return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Node format: data length, data, child count, then for each child: key length, key, node
+// ------------------------------------------------------------------------------------------------
+
+static void write_string(std::string& out, const std::string& s)
+{
+    const uint32_t length = (uint32_t) s.size();
+    out.append((const char*) &length, sizeof(length));
+    out.append(s);
+}
+
+static bool read_u32(const char*& pos, const char* end, uint32_t& value)
+{
+    if (end - pos < (ptrdiff_t) sizeof(uint32_t))
+        return false;
+
+    memcpy(&value, pos, sizeof(uint32_t));
+    pos += sizeof(uint32_t);
+    return true;
+}
+
+static bool read_string(const char*& pos, const char* end, std::string& s)
+{
+    uint32_t length;
+    if (!read_u32(pos, end, length) || (uint32_t) (end - pos) < length)
+        return false;
+
+    s.assign(pos, length);
+    pos += length;
+    return true;
+}
+
+void XmlSnapshot::write_node(std::string& out, const ptree& node)
+{
+    write_string(out, node.data());
+
+    const uint32_t children = (uint32_t) node.size();
+    out.append((const char*) &children, sizeof(children));
+
+    for (ptree::const_iterator it = node.begin(); it != node.end(); ++it)
+    {
+        write_string(out, it->first);
+        write_node(out, it->second);
+    }
+}
+
+bool XmlSnapshot::read_node(const char*& pos, const char* end, ptree& node)
+{
+    uint32_t children;
+    if (!read_string(pos, end, node.data()) || !read_u32(pos, end, children))
+        return false;
+
+    for (uint32_t i = 0; i < children; i++)
+    {
+        std::string key;
+        if (!read_string(pos, end, key))
+            return false;
+
+        ptree& child = node.push_back(std::make_pair(key, ptree()))->second;
+        if (!read_node(pos, end, child))
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,55 @@
+/***************************************************************************
+    XML Snapshots.
+
+    A compact binary copy of a property tree read from an XML file, so the
+    XML need not be parsed again on the next run.
+
+    The snapshot is tied to the modification time, size and CRC of the
+    XML file, which remains the editable source of truth. If the XML
+    changes, the snapshot is ignored and replaced. The CRC catches edits
+    that keep the size within the one second resolution of the time.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#pragma once
+
+#include <string>
+#include <boost/property_tree/ptree.hpp>
+#include "stdint.hpp"
+
+class XmlSnapshot
+{
+public:
+    // Snapshot file for an XML file
+    static std::string filename(const std::string& xml_file) { return xml_file + ".bin"; }
+
+    // Load a property tree from the snapshot of an XML file.
+    // Returns false if there is no snapshot, or the XML has changed since it was taken.
+    static bool load(const std::string& xml_file, boost::property_tree::ptree& pt);
+
+    // Create a snapshot of a property tree, just read from an XML file
+    static bool build(const std::string& xml_file, const boost::property_tree::ptree& pt, std::string& snapshot);
+
+private:
+    const static uint32_t VERSION = 2;
+
+    // Identifies the byte order of the machine that wrote the file
+    const static uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    struct header_t
+    {
+        char     magic[4];
+        uint32_t version;
+        uint32_t byte_order;
+        uint32_t xml_crc;
+        int64_t  xml_mtime;
+        uint64_t xml_size;
+    };
+
+    static bool stat_xml(const std::string& xml_file, int64_t& mtime, uint64_t& size);
+    static bool crc_xml(const std::string& xml_file, uint32_t& crc);
+    static void write_node(std::string& out, const boost::property_tree::ptree& node);
+    static bool read_node(const char*& pos, const char* end, boost::property_tree::ptree& node);
+};
@@ -0,0 +1,180 @@
+/***************************************************************************
+    Audio Mixer.
+
+    Mixes the YM2151, Sega PCM and WAV streams into a single 16-bit stereo
+    buffer. Each source has its own gain, followed by a master gain.
+
+    Sources are combined with saturating adds. SSE2 and NEON versions are
+    used where the compiler supports them, with a plain C++ fallback.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include "hwaudio/mixer.hpp"
+
+#if defined MIXER_SSE2
+#include <emmintrin.h>
+#elif defined MIXER_NEON
+#include <arm_neon.h>
+#endif
+
+Mixer::Mixer()
+{
+    for (int i = 0; i < GAINS; i++)
+        gain[i] = GAIN_UNITY;
+}
+
+Mixer::~Mixer()
+{
+}
+
+void Mixer::set_gain(int source, int percent)
+{
+    if (source < 0 || source >= GAINS)
+        return;
+
+    if (percent < 0)             percent = 0;
+    else if (percent > GAIN_MAX) percent = GAIN_MAX;
+
+    gain[source] = (int16_t) ((percent * GAIN_UNITY) / 100);
+}
+
+int Mixer::get_gain(int source)
+{
+    if (source < 0 || source >= GAINS)
+        return 0;
+
+    return (gain[source] * 100) / GAIN_UNITY;
+}
+
+void Mixer::mix(int16_t* dst, const int16_t* ym, const int16_t* pcm, uint32_t samples,
+                const int16_t* wav, uint32_t& wav_pos, uint32_t wav_len)
+{
+    if (wav == NULL || wav_len == 0 || gain[WAV] == 0)
+    {
+        mix_block(dst, ym, pcm, NULL, samples);
+        return;
+    }
+
+    // Mix in blocks up to the end of the WAV data, rather than checking for the loop point every sample
+    uint32_t done = 0;
+    while (done < samples)
+    {
+        uint32_t block = wav_len - wav_pos;
+        if (block > samples - done)
+            block = samples - done;
+
+        mix_block(dst + done, ym + done, pcm + done, wav + wav_pos, block);
+
+        done    += block;
+        wav_pos += block;
+        if (wav_pos >= wav_len)
+            wav_pos = 0;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Scalar Mixer
+// ----------------------------------------------------------------------------
+
+static inline int16_t saturate(int32_t v)
+{
+    if (v > INT16_MAX)      return INT16_MAX;
+    else if (v < INT16_MIN) return INT16_MIN;
+    return (int16_t) v;
+}
+
+void Mixer::mix_block_scalar(int16_t* dst, const int16_t* ym, const int16_t* pcm, const int16_t* wav, uint32_t samples)
+{
+    const int32_t g_ym  = gain[YM];
+    const int32_t g_pcm = gain[PCM];
+    const int32_t g_wav = gain[WAV];
+    const int32_t g_mst = gain[MASTER];
+
+    for (uint32_t i = 0; i < samples; i++)
+    {
+        int16_t s = saturate(saturate((ym[i] * g_ym) >> GAIN_SHIFT) + saturate((pcm[i] * g_pcm) >> GAIN_SHIFT));
+        if (wav)
+            s = saturate(s + saturate((wav[i] * g_wav) >> GAIN_SHIFT));
+        dst[i] = saturate((s * g_mst) >> GAIN_SHIFT);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Vector Mixer
+//
+// Each gain stage multiplies to 32-bit, shifts and packs back to 16-bit with
+// saturation, so the results match the scalar mixer exactly.
+// ----------------------------------------------------------------------------
+
+#if defined MIXER_SSE2
+
+static inline __m128i apply_gain(__m128i x, __m128i g)
+{
+    __m128i lo = _mm_mullo_epi16(x, g);
+    __m128i hi = _mm_mulhi_epi16(x, g);
+    __m128i p0 = _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), Mixer::GAIN_SHIFT);
+    __m128i p1 = _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), Mixer::GAIN_SHIFT);
+    return _mm_packs_epi32(p0, p1);
+}
+
+void Mixer::mix_block(int16_t* dst, const int16_t* ym, const int16_t* pcm, const int16_t* wav, uint32_t samples)
+{
+    const __m128i g_ym  = _mm_set1_epi16(gain[YM]);
+    const __m128i g_pcm = _mm_set1_epi16(gain[PCM]);
+    const __m128i g_wav = _mm_set1_epi16(gain[WAV]);
+    const __m128i g_mst = _mm_set1_epi16(gain[MASTER]);
+
+    uint32_t i = 0;
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m128i s = _mm_adds_epi16(apply_gain(_mm_loadu_si128((const __m128i*) (ym + i)), g_ym),
+                                   apply_gain(_mm_loadu_si128((const __m128i*) (pcm + i)), g_pcm));
+        if (wav)
+            s = _mm_adds_epi16(s, apply_gain(_mm_loadu_si128((const __m128i*) (wav + i)), g_wav));
+        _mm_storeu_si128((__m128i*) (dst + i), apply_gain(s, g_mst));
+    }
+
+    if (i < samples)
+        mix_block_scalar(dst + i, ym + i, pcm + i, wav ? wav + i : NULL, samples - i);
+}
+
+#elif defined MIXER_NEON
+
+static inline int16x8_t apply_gain(int16x8_t x, int16x4_t g)
+{
+    int32x4_t p0 = vshrq_n_s32(vmull_s16(vget_low_s16(x),  g), Mixer::GAIN_SHIFT);
+    int32x4_t p1 = vshrq_n_s32(vmull_s16(vget_high_s16(x), g), Mixer::GAIN_SHIFT);
+    return vcombine_s16(vqmovn_s32(p0), vqmovn_s32(p1));
+}
+
+void Mixer::mix_block(int16_t* dst, const int16_t* ym, const int16_t* pcm, const int16_t* wav, uint32_t samples)
+{
+    const int16x4_t g_ym  = vdup_n_s16(gain[YM]);
+    const int16x4_t g_pcm = vdup_n_s16(gain[PCM]);
+    const int16x4_t g_wav = vdup_n_s16(gain[WAV]);
+    const int16x4_t g_mst = vdup_n_s16(gain[MASTER]);
+
+    uint32_t i = 0;
+    for (; i + 8 <= samples; i += 8)
+    {
+        int16x8_t s = vqaddq_s16(apply_gain(vld1q_s16(ym + i), g_ym),
+                                 apply_gain(vld1q_s16(pcm + i), g_pcm));
+        if (wav)
+            s = vqaddq_s16(s, apply_gain(vld1q_s16(wav + i), g_wav));
+        vst1q_s16(dst + i, apply_gain(s, g_mst));
+    }
+
+    if (i < samples)
+        mix_block_scalar(dst + i, ym + i, pcm + i, wav ? wav + i : NULL, samples - i);
+}
+
+#else
+
+void Mixer::mix_block(int16_t* dst, const int16_t* ym, const int16_t* pcm, const int16_t* wav, uint32_t samples)
+{
+    mix_block_scalar(dst, ym, pcm, wav, samples);
+}
+
+#endif
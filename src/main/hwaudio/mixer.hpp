@@ -0,0 +1,64 @@
+/***************************************************************************
+    Audio Mixer.
+
+    Mixes the YM2151, Sega PCM and WAV streams into a single 16-bit stereo
+    buffer. Each source has its own gain, followed by a master gain.
+
+    Sources are combined with saturating adds. SSE2 and NEON versions are
+    used where the compiler supports them, with a plain C++ fallback.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#pragma once
+
+#include "stdint.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIXER_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define MIXER_NEON 1
+#endif
+
+class Mixer
+{
+public:
+    // Sources
+    enum
+    {
+        YM,
+        PCM,
+        WAV,
+        MASTER,
+        GAINS
+    };
+
+    // Gain as a percentage: 0 = Off, 100 = Unchanged, 200 = Maximum
+    const static int GAIN_MAX = 200;
+
+    // Fixed point gain: 1 << GAIN_SHIFT represents unity gain
+    const static int GAIN_SHIFT = 8;
+    const static int GAIN_UNITY = 1 << GAIN_SHIFT;
+
+    Mixer();
+    ~Mixer();
+
+    void set_gain(int source, int percent);
+    int get_gain(int source);
+
+    // Mix a frame of interleaved samples into dst.
+    //
+    // samples:  Number of int16 values in dst, ym and pcm
+    // wav:      Looping WAV source (or NULL if none loaded)
+    // wav_pos:  Current position in the WAV source. Updated on return.
+    // wav_len:  Length of the WAV source in int16 values
+    void mix(int16_t* dst, const int16_t* ym, const int16_t* pcm, uint32_t samples,
+             const int16_t* wav, uint32_t& wav_pos, uint32_t wav_len);
+
+private:
+    int16_t gain[GAINS];
+
+    void mix_block(int16_t* dst, const int16_t* ym, const int16_t* pcm, const int16_t* wav, uint32_t samples);
+    void mix_block_scalar(int16_t* dst, const int16_t* ym, const int16_t* pcm, const int16_t* wav, uint32_t samples);
+};
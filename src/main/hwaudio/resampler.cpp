@@ -0,0 +1,190 @@
+/***************************************************************************
+    Polyphase Resampler.
+
+    Converts a frame of 16-bit stereo samples from one sample rate to
+    another, using a windowed sinc filter. This allows a sound chip to be
+    synthesised at a lower rate than the audio device.
+
+    The number of input and output samples per frame is fixed, so the
+    conversion ratio is exact and there is no drift between frames.
+
+    SSE2 and NEON versions of the filter are used where the compiler
+    supports them, with a plain C++ fallback.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include <cmath>
+#include "hwaudio/resampler.hpp"
+
+#if defined RESAMPLER_SSE2
+#include <emmintrin.h>
+#elif defined RESAMPLER_NEON
+#include <arm_neon.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Filter length and passband (fraction of the lower Nyquist frequency) for each quality level
+static const int    QUALITY_TAPS[]    = { 8,    16,   32   };
+static const double QUALITY_ROLLOFF[] = { 0.80, 0.90, 0.95 };
+
+Resampler::Resampler()
+{
+    coefs = NULL;
+    left  = NULL;
+    right = NULL;
+}
+
+Resampler::~Resampler()
+{
+    free_buffers();
+}
+
+void Resampler::free_buffers()
+{
+    delete[] coefs;
+    delete[] left;
+    delete[] right;
+    coefs = NULL;
+    left  = NULL;
+    right = NULL;
+}
+
+void Resampler::init(uint32_t in_frames, uint32_t out_frames, int quality)
+{
+    free_buffers();
+
+    if (quality < 0)                quality = 0;
+    else if (quality > QUALITY_MAX) quality = QUALITY_MAX;
+
+    this->in_frames  = in_frames;
+    this->out_frames = out_frames;
+    taps             = QUALITY_TAPS[quality];
+
+    // Cutoff relative to the input rate. When downsampling, this also removes frequencies the output can't represent.
+    const double ratio  = in_frames < out_frames ? 1.0 : (double) out_frames / in_frames;
+    const double cutoff = 0.5 * ratio * QUALITY_ROLLOFF[quality];
+
+    coefs = new int16_t[PHASES * taps];
+
+    for (int p = 0; p < PHASES; p++)
+    {
+        double h[64];
+        double sum = 0;
+
+        for (int t = 0; t < taps; t++)
+        {
+            // Distance from the output position to this input sample
+            double x = t + 1 - (taps / 2) - ((double) p / PHASES);
+            double s = x == 0 ? 1.0 : sin(2 * M_PI * cutoff * x) / (2 * M_PI * cutoff * x);
+
+            // Blackman window
+            double n = (x + (taps / 2)) / taps;
+            double w = 0.42 - 0.5 * cos(2 * M_PI * n) + 0.08 * cos(4 * M_PI * n);
+
+            h[t] = s * w;
+            sum += h[t];
+        }
+
+        // Normalise each phase to unity gain, so there is no ripple between phases
+        for (int t = 0; t < taps; t++)
+            coefs[(p * taps) + t] = (int16_t) floor(((h[t] / sum) * (1 << COEF_SHIFT)) + 0.5);
+    }
+
+    left  = new int16_t[taps + in_frames];
+    right = new int16_t[taps + in_frames];
+
+    for (uint32_t i = 0; i < taps + in_frames; i++)
+        left[i] = right[i] = 0;
+}
+
+static inline int16_t saturate(int32_t v)
+{
+    if (v > INT16_MAX)      return INT16_MAX;
+    else if (v < INT16_MIN) return INT16_MIN;
+    return (int16_t) v;
+}
+
+void Resampler::process(const int16_t* src, int16_t* dst)
+{
+    // Keep the end of the previous frame as history for the filter
+    for (int i = 0; i < taps; i++)
+    {
+        left[i]  = left[in_frames + i];
+        right[i] = right[in_frames + i];
+    }
+
+    for (uint32_t i = 0; i < in_frames; i++)
+    {
+        left[taps + i]  = src[(i << 1) + 0];
+        right[taps + i] = src[(i << 1) + 1];
+    }
+
+    const int32_t round = 1 << (COEF_SHIFT - 1);
+
+    for (uint32_t i = 0; i < out_frames; i++)
+    {
+        // Position of this output sample in the input, as a whole sample and fraction
+        const uint32_t pos   = i * in_frames;
+        const uint32_t index = pos / out_frames;
+        const uint32_t phase = ((pos % out_frames) << PHASE_BITS) / out_frames;
+
+        // Filter the taps samples ending at the current input sample. This delays the output by taps / 2 samples.
+        const int16_t* coef = coefs + (phase * taps);
+        dst[(i << 1) + 0] = saturate((dot(left  + index + 1, coef, taps) + round) >> COEF_SHIFT);
+        dst[(i << 1) + 1] = saturate((dot(right + index + 1, coef, taps) + round) >> COEF_SHIFT);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Filter. taps is always a multiple of 8.
+// ----------------------------------------------------------------------------
+
+#if defined RESAMPLER_SSE2
+
+int32_t Resampler::dot(const int16_t* src, const int16_t* coef, int taps)
+{
+    __m128i acc = _mm_setzero_si128();
+
+    for (int t = 0; t < taps; t += 8)
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_loadu_si128((const __m128i*) (src + t)),
+                                                _mm_loadu_si128((const __m128i*) (coef + t))));
+
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(acc);
+}
+
+#elif defined RESAMPLER_NEON
+
+int32_t Resampler::dot(const int16_t* src, const int16_t* coef, int taps)
+{
+    int32x4_t acc = vdupq_n_s32(0);
+
+    for (int t = 0; t < taps; t += 8)
+    {
+        int16x8_t s = vld1q_s16(src + t);
+        int16x8_t c = vld1q_s16(coef + t);
+        acc = vmlal_s16(acc, vget_low_s16(s),  vget_low_s16(c));
+        acc = vmlal_s16(acc, vget_high_s16(s), vget_high_s16(c));
+    }
+
+    int32x2_t sum = vadd_s32(vget_low_s32(acc), vget_high_s32(acc));
+    return vget_lane_s32(vpadd_s32(sum, sum), 0);
+}
+
+#else
+
+int32_t Resampler::dot(const int16_t* src, const int16_t* coef, int taps)
+{
+    int32_t acc = 0;
+    for (int t = 0; t < taps; t++)
+        acc += src[t] * coef[t];
+    return acc;
+}
+
+#endif
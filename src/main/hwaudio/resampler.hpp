@@ -0,0 +1,68 @@
+/***************************************************************************
+    Polyphase Resampler.
+
+    Converts a frame of 16-bit stereo samples from one sample rate to
+    another, using a windowed sinc filter. This allows a sound chip to be
+    synthesised at a lower rate than the audio device.
+
+    The number of input and output samples per frame is fixed, so the
+    conversion ratio is exact and there is no drift between frames.
+
+    SSE2 and NEON versions of the filter are used where the compiler
+    supports them, with a plain C++ fallback.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#pragma once
+
+#include "stdint.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RESAMPLER_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define RESAMPLER_NEON 1
+#endif
+
+class Resampler
+{
+public:
+    // Quality: 0 = Fastest, 2 = Best
+    const static int QUALITY_MAX = 2;
+
+    Resampler();
+    ~Resampler();
+
+    // in_frames:  Stereo samples input per frame
+    // out_frames: Stereo samples output per frame
+    void init(uint32_t in_frames, uint32_t out_frames, int quality);
+
+    // Convert a frame of interleaved stereo samples
+    // src: in_frames * 2 values
+    // dst: out_frames * 2 values
+    void process(const int16_t* src, int16_t* dst);
+
+private:
+    // Filter coefficients are fixed point, with this many fractional bits
+    const static int COEF_SHIFT = 14;
+
+    // Number of fractional positions between input samples that have their own filter
+    const static int PHASE_BITS = 8;
+    const static int PHASES     = 1 << PHASE_BITS;
+
+    uint32_t in_frames, out_frames;
+
+    // Filter length (multiple of 8)
+    int taps;
+
+    // Filter coefficients: PHASES filters of taps coefficients each
+    int16_t* coefs;
+
+    // Input for each channel: the last taps samples of the previous frame, followed by the current frame
+    int16_t* left;
+    int16_t* right;
+
+    void free_buffers();
+    static int32_t dot(const int16_t* src, const int16_t* coef, int taps);
+};
@@ -87,8 +87,13 @@ SegaPCM::~SegaPCM()
 void SegaPCM::init(int32_t rate, int32_t fps)
 {
     this->sample_freq = rate;
-    downsample = (32000.0 / (double) rate);
     SoundChip::init(STEREO, rate, fps);
+
+    // Cannonball Change: Output at a fixed 44,100Hz.
+    // Pre-calculate the scaled increment for every pitch value, rather than per sample.
+    const double downsample = (32000.0 / (double) rate);
+    for (int32_t i = 0; i < 0x100; i++)
+        delta_tab[i] = (uint32_t) (i * downsample);
 }
 
 void SegaPCM::stream_update()
@@ -108,6 +113,7 @@ void SegaPCM::stream_update()
             uint32_t addr = (regs[0x85] << 16) | (regs[0x84] << 8) | low[ch];
             uint32_t loop = (regs[0x05] << 16) | (regs[0x04] << 8);
             uint8_t end   =  regs[0x06] + 1;
+            uint32_t inc  =  delta_tab[regs[0x07]];
 
             uint32_t i;
 
@@ -138,9 +144,7 @@ void SegaPCM::stream_update()
                 write_buffer(RIGHT, i, read_buffer(RIGHT, i) + (v * regs[3]));
 
                 // Advance.
-                // Cannonball Change: Output at a fixed 44,100Hz. 
-                double increment = ((double)regs[7]) * downsample;
-                addr = (addr + (int) increment) & 0xffffff;
+                addr = (addr + inc) & 0xffffff;
             }
 
             // store back the updated address and info
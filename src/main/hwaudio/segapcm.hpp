@@ -41,5 +41,6 @@ private:
     int32_t bankmask;
     int32_t rgnmask;
 
-    double downsample;
+    // Address increment for each delta (pitch) value at the output sample rate
+    uint32_t delta_tab[0x100];
 };
\ No newline at end of file
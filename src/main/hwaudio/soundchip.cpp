@@ -13,13 +13,17 @@
 
 SoundChip::SoundChip()
 {
-    volume     = 1.0;
+    volume     = 100;
     initalized = false;
+    resampler  = NULL;
+    output     = NULL;
 }
 
 SoundChip::~SoundChip()
 {
     delete[] buffer;
+    delete resampler;
+    delete[] output;
 }
 
 void SoundChip::init(uint8_t channels, int32_t sample_freq, int32_t fps)
@@ -29,34 +33,67 @@ void SoundChip::init(uint8_t channels, int32_t sample_freq, int32_t fps)
     this->channels    = channels;
 
     frame_size =  sample_freq / fps;
-    buffer_size = frame_size * channels;
+    synth_size = frame_size * channels;
+    buffer_size = synth_size;
 
     if (initalized)
         delete[] buffer;
     
-    buffer = new int16_t[buffer_size];
+    buffer = new int16_t[synth_size];
+
+    delete resampler;
+    delete[] output;
+    resampler = NULL;
+    output    = NULL;
 
     initalized = true;
 }
 
-// Set soundchip volume (0 = Off, 10 = Loudest)
-void SoundChip::set_volume(uint8_t v)
+void SoundChip::set_output_rate(int32_t output_freq, int quality)
 {
-    if (v > 10) 
+    if (output_freq == (int32_t) sample_freq || channels != STEREO)
         return;
+
+    const uint32_t output_frames = output_freq / fps;
+
+    resampler = new Resampler();
+    resampler->init(frame_size, output_frames, quality);
+
+    buffer_size = output_frames * channels;
+    output = new int16_t[buffer_size];
+    for (uint32_t i = 0; i < buffer_size; i++)
+        output[i] = 0;
+}
+
+// Set soundchip volume as a percentage (0 = Off, 100 = Normal, 200 = Loudest)
+void SoundChip::set_volume(int v)
+{
+    if (v < 0)        v = 0;
+    else if (v > 200) v = 200;
     
-    volume = (float) (v / 10.0);
+    volume = v;
+}
+
+int SoundChip::get_volume()
+{
+    return volume;
 }
 
 void SoundChip::clear_buffer()
 {
-    for (uint32_t i = 0; i < buffer_size; i++)
+    for (uint32_t i = 0; i < synth_size; i++)
         buffer[i] = 0;
 }
 
+// Convert the frame just synthesised to the output rate
+void SoundChip::resample_buffer()
+{
+    if (resampler)
+        resampler->process(buffer, output);
+}
+
 void SoundChip::write_buffer(const uint8_t channel, uint32_t address, int16_t value)
 {
-    //buffer[channel + (address * channels)] = (int16_t) (value * volume); // Unused for now
     buffer[channel + (address * channels)] = value;
 }
 
@@ -67,5 +104,5 @@ int16_t SoundChip::read_buffer(const uint8_t channel, uint32_t address)
 
 int16_t* SoundChip::get_buffer()
 {
-    return buffer;
+    return resampler ? output : buffer;
 }
\ No newline at end of file
@@ -10,6 +10,8 @@
 
 #pragma once
 
+#include "hwaudio/resampler.hpp"
+
 class SoundChip
 {
 public:
@@ -21,7 +23,7 @@ public:
     // How many channels to support (mono/stereo)
     uint8_t channels;
 
-    // Size of the buffer (including channel info)
+    // Size of the output buffer (including channel info)
     uint32_t buffer_size;
 
     SoundChip();
@@ -29,11 +31,15 @@ public:
 
     void init(uint8_t, int32_t, int32_t);
 
+    // Resample the output to the given rate, when the chip is synthesised at a different rate (stereo only)
+    void set_output_rate(int32_t output_freq, int quality);
+
     // Pure virtual function. Denotes virtual class.
     virtual void stream_update() = 0;
 
     int16_t* get_buffer();
-    void set_volume(uint8_t);
+    void set_volume(int);
+    int get_volume();
 
 protected:
     const static uint8_t MONO             = 1;
@@ -45,10 +51,14 @@ protected:
     //  Buffer size for one frame (excluding channel info)
     uint32_t frame_size;
 
-    // Volume of sound chip
-    float volume;
+    // Volume of sound chip as a percentage. Applied by the mixer.
+    int volume;
+
+    // Size of the synthesis buffer (including channel info)
+    uint32_t synth_size;
 
     void clear_buffer();
+    void resample_buffer();
     void write_buffer(const uint8_t, uint32_t, int16_t);
     int16_t read_buffer(const uint8_t, uint32_t);
 
@@ -56,6 +66,10 @@ private:
     // Sound buffer stream
     int16_t* buffer;
 
+    // Converts buffer to the output rate, or NULL if not required
+    Resampler* resampler;
+    int16_t* output;
+
     // Frames per second
     uint32_t fps; 
 };
\ No newline at end of file
@@ -13,8 +13,10 @@
 #include <stdlib.h>
 #include <cmath>
 #include <cstring>  // For memset on GCC
+#include <iostream>
 
 #include "hwaudio/ym2151.hpp"
+#include "hwaudio/ym2151_tables.hpp"
 
 signed int     chanout[8];
 signed int     m2,c1,c2;            /* Phase Modulation input for operators 2,3,4  */
@@ -140,15 +142,16 @@ uint32_t       noise_tab[32];       /* 17bit Noise Generator periods */
 *   TL_RES_LEN - sinus resolution (X axis)
 */
 #define TL_TAB_LEN (13*2*TL_RES_LEN)
-static signed int tl_tab[TL_TAB_LEN];
 
 #define ENV_QUIET        (TL_TAB_LEN>>3)
 
-/* sin waveform table in 'decibel' scale */
-static unsigned int sin_tab[SIN_LEN];
+/* tl_tab, sin_tab and d1l_tab are read-only data in ym2151_tables.hpp */
+static_assert(sizeof(tl_tab)  / sizeof(tl_tab[0])  == TL_TAB_LEN, "tl_tab size mismatch");
+static_assert(sizeof(sin_tab) / sizeof(sin_tab[0]) == SIN_LEN,    "sin_tab size mismatch");
 
-/* translate from D1L to volume index (16 D1L levels) */
-static uint32_t d1l_tab[16];
+/* sample rate and clock that the rate dependent tables were last built for */
+static int chip_tables_rate  = 0;
+static int chip_tables_clock = 0;
 
 #define RATE_STEPS (8)
 static const uint8_t eg_inc[19*RATE_STEPS]={
@@ -419,10 +422,18 @@ YM2151::~YM2151()
 }
 
 
-void YM2151::init_tables()
+/* verify the pre-calculated tables against the original MAME table code */
+/* #define VERIFY_TABLES */
+#ifdef VERIFY_TABLES
+static void verify_tables()
 {
     signed int i,x,n;
     double o,m;
+    int errors = 0;
+
+    static signed int   ref_tl_tab[TL_TAB_LEN];
+    static unsigned int ref_sin_tab[SIN_LEN];
+    static uint32_t     ref_d1l_tab[16];
 
     for (x=0; x<TL_RES_LEN; x++)
     {
@@ -440,24 +451,15 @@ void YM2151::init_tables()
             n = n>>1;
                         /* 11 bits here (rounded) */
         n <<= 2;        /* 13 bits here (as in real chip) */
-        tl_tab[ x*2 + 0 ] = n;
-        tl_tab[ x*2 + 1 ] = -tl_tab[ x*2 + 0 ];
+        ref_tl_tab[ x*2 + 0 ] = n;
+        ref_tl_tab[ x*2 + 1 ] = -ref_tl_tab[ x*2 + 0 ];
 
         for (i=1; i<13; i++)
         {
-            tl_tab[ x*2+0 + i*2*TL_RES_LEN ] =  tl_tab[ x*2+0 ]>>i;
-            tl_tab[ x*2+1 + i*2*TL_RES_LEN ] = -tl_tab[ x*2+0 + i*2*TL_RES_LEN ];
+            ref_tl_tab[ x*2+0 + i*2*TL_RES_LEN ] =  ref_tl_tab[ x*2+0 ]>>i;
+            ref_tl_tab[ x*2+1 + i*2*TL_RES_LEN ] = -ref_tl_tab[ x*2+0 + i*2*TL_RES_LEN ];
         }
-    #if 0
-        logerror("tl %04i", x*2);
-        for (i=0; i<13; i++)
-            logerror(", [%02i] %4i", i*2, tl_tab[ x*2 /*+1*/ + i*2*TL_RES_LEN ]);
-        logerror("\n");
-    #endif
     }
-    /*logerror("TL_TAB_LEN = %i (%i bytes)\n",TL_TAB_LEN, (int)sizeof(tl_tab));*/
-    /*logerror("ENV_QUIET= %i\n",ENV_QUIET );*/
-
 
     for (i=0; i<SIN_LEN; i++)
     {
@@ -479,32 +481,26 @@ void YM2151::init_tables()
         else
             n = n>>1;
 
-        sin_tab[ i ] = n*2 + (m>=0.0? 0: 1 );
-        /*logerror("sin [0x%4x]= %4i (tl_tab value=%8x)\n", i, sin_tab[i],tl_tab[sin_tab[i]]);*/
+        ref_sin_tab[ i ] = n*2 + (m>=0.0? 0: 1 );
     }
     /* calculate d1l_tab table */
     for (i=0; i<16; i++)
     {
         m = (i!=15 ? i : i+16) * (4.0/ENV_STEP);   /* every 3 'dB' except for all bits = 1 = 45+48 'dB' */
-        d1l_tab[i] = (uint32_t) m;
-        /*logerror("d1l_tab[%02x]=%08x\n",i,d1l_tab[i] );*/
+        ref_d1l_tab[i] = (uint32_t) m;
     }
 
-#ifdef SAVE_SAMPLE
-    sample[8]=fopen("sampsum.pcm","wb");
-#endif
-#ifdef SAVE_SEPARATE_CHANNELS
-    sample[0]=fopen("samp0.pcm","wb");
-    sample[1]=fopen("samp1.pcm","wb");
-    sample[2]=fopen("samp2.pcm","wb");
-    sample[3]=fopen("samp3.pcm","wb");
-    sample[4]=fopen("samp4.pcm","wb");
-    sample[5]=fopen("samp5.pcm","wb");
-    sample[6]=fopen("samp6.pcm","wb");
-    sample[7]=fopen("samp7.pcm","wb");
-#endif
-}
+    for (i=0; i<TL_TAB_LEN; i++)
+        if (tl_tab[i] != ref_tl_tab[i]) errors++;
+    for (i=0; i<SIN_LEN; i++)
+        if (sin_tab[i] != ref_sin_tab[i]) errors++;
+    for (i=0; i<16; i++)
+        if (d1l_tab[i] != ref_d1l_tab[i]) errors++;
 
+    if (errors)
+        std::cout << "YM2151: " << errors << " lookup table entries differ from reference" << std::endl;
+}
+#endif
 
 void YM2151::init_chip_tables()
 {
@@ -513,6 +509,13 @@ void YM2151::init_chip_tables()
     double scaler;
     double pom;
 
+    /* tables only depend on clock and sample rate, so skip rebuilding them on audio restart */
+    if (chip_tables_rate == sampfreq && chip_tables_clock == clock)
+        return;
+
+    chip_tables_rate  = sampfreq;
+    chip_tables_clock = clock;
+
     scaler = ( (double)clock / 64.0 ) / ( (double)sampfreq );
     /*logerror("scaler    = %20.15f\n", scaler);*/
 
@@ -1291,8 +1294,24 @@ int YM2151::read_status()
 void YM2151::init(int rate, int fps)
 {
     SoundChip::init(STEREO, rate, fps);
-    this->sampfreq = rate;
-    init_tables();
+
+#ifdef VERIFY_TABLES
+    verify_tables();
+#endif
+
+#ifdef SAVE_SAMPLE
+    sample[8]=fopen("sampsum.pcm","wb");
+#endif
+#ifdef SAVE_SEPARATE_CHANNELS
+    sample[0]=fopen("samp0.pcm","wb");
+    sample[1]=fopen("samp1.pcm","wb");
+    sample[2]=fopen("samp2.pcm","wb");
+    sample[3]=fopen("samp3.pcm","wb");
+    sample[4]=fopen("samp4.pcm","wb");
+    sample[5]=fopen("samp5.pcm","wb");
+    sample[6]=fopen("samp6.pcm","wb");
+    sample[7]=fopen("samp7.pcm","wb");
+#endif
 
     this->sampfreq = rate ? rate : 44100;    /* avoid division by 0 in init_chip_tables() */
 
@@ -2107,4 +2126,6 @@ void YM2151::stream_update()
 #endif
         advance();
     }
+
+    resample_buffer();
 }
\ No newline at end of file
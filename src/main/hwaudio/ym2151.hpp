@@ -86,7 +86,6 @@ private:
     int sampfreq;     /*sampling frequency in Hz (passed from 2151intf.c)*/
     float volume;
 
-    void init_tables();
     void init_chip_tables();
     inline void envelope_KONKOFF(YM2151Operator * op, int v);
     inline void set_connect(YM2151Operator *om1, int cha, int v);
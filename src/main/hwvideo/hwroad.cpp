@@ -2,6 +2,8 @@
 #include "hwvideo/hwroad.hpp"
 #include "globals.hpp"
 #include "frontend/config.hpp"
+#include "savestate.hpp"
+#include "hwvideo/interpolate.hpp"
 
 /***************************************************************************
     Video Emulation: OutRun Road Rendering Hardware.
@@ -110,10 +112,13 @@ HWRoad hwroad;
 
 HWRoad::HWRoad()
 {
+    roads      = NULL;
+    roads_data = NULL;
 }
 
 HWRoad::~HWRoad()
 {
+    delete[] roads_data;
 }
 
 // Convert road to a more useable format
@@ -165,6 +170,11 @@ void HWRoad::init(const uint8_t* src_road, const bool hires)
 
 void HWRoad::decode_road(const uint8_t* src_road)
 {
+    if (roads_data == NULL)
+        roads_data = new uint8_t[ROADS_LENGTH];
+
+    uint8_t* roads = roads_data;
+
     for (int y = 0; y < 256 * 2; y++) 
     {
         const int src = ((y & 0xff) * 0x40 + (y >> 8) * 0x8000) % rom_size; // tempGfx
@@ -186,6 +196,24 @@ void HWRoad::decode_road(const uint8_t* src_road)
     {
         roads[256 * 2 * 512 + i] = 3;
     }
+
+    this->roads = roads_data;
+}
+
+void HWRoad::set_decoded(const uint8_t* src)
+{
+    if (roads_data == NULL)
+        roads_data = new uint8_t[ROADS_LENGTH];
+
+    memcpy(roads_data, src, ROADS_LENGTH);
+    roads = roads_data;
+}
+
+void HWRoad::use_shared(const uint8_t* src)
+{
+    delete[] roads_data;
+    roads_data = NULL;
+    roads = src;
 }
 
 // Writes go to RAM, but we read from the RAM Buffer.
@@ -225,6 +253,36 @@ uint16_t HWRoad::read_road_control()
     return 0xffff;
 }
 
+// Both halves of road RAM, and the registers
+void HWRoad::add_state(SaveState& state)
+{
+    state.add(ram);
+    state.add(ramBuff);
+    state.add(road_control);
+    state.add(color_offset1);
+    state.add(color_offset2);
+    state.add(color_offset3);
+    state.add(x_offset);
+}
+
+void HWRoad::save_previous()
+{
+    memcpy(hscroll_prev, ramBuff + HSCROLL, sizeof(hscroll_prev));
+}
+
+void HWRoad::interpolate(float alpha)
+{
+    memcpy(hscroll_current, ramBuff + HSCROLL, sizeof(hscroll_current));
+
+    for (uint16_t i = 0; i < HSCROLL_SIZE; i++)
+        ramBuff[HSCROLL + i] = interpolate_field(hscroll_prev[i], hscroll_current[i], 0xfff, 0x80, alpha);
+}
+
+void HWRoad::restore()
+{
+    memcpy(ramBuff + HSCROLL, hscroll_current, sizeof(hscroll_current));
+}
+
 void HWRoad::write_road_control(const uint8_t road_control)
 {
     this->road_control = road_control;
@@ -314,7 +372,7 @@ void HWRoad::render_foreground_lores(uint16_t* pixels)
         int32_t hpos0, hpos1, color0, color1;
         int32_t control = road_control & 3;
 
-        uint8_t *src0, *src1;
+        const uint8_t *src0, *src1;
         int32_t bgcolor; // 8 bits
 
         // get road 0 data
@@ -501,7 +559,7 @@ void HWRoad::render_foreground_hires(uint16_t* pixels)
             continue;
         }
 
-        uint8_t *src0 = NULL, *src1 = NULL;
+        const uint8_t *src0 = NULL, *src1 = NULL;
 
         // get road 0 data
         int32_t hpos0  = roadram[0x200 + (((road_control & 4) != 0) ? yy : (data0 & 0x1ff))] & 0xfff;
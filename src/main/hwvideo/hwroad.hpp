@@ -2,18 +2,42 @@
 
 #include "stdint.hpp"
 
+class SaveState;
+
 class HWRoad
 {
 public:
+    static const uint32_t ROADS_LENGTH = 0x40200;
+
     HWRoad();
     ~HWRoad();
 
     void init(const uint8_t*, const bool hires);
+
+    // Decode road graphics. Independent of the video mode, so can run on a worker thread.
+    void decode_road(const uint8_t*);
+
+    // Decoded road graphics, for caching between runs
+    const uint8_t* get_decoded() const { return roads; }
+    void set_decoded(const uint8_t* src);
+
+    // Use decoded road graphics in shared read-only memory, rather than a private copy
+    void use_shared(const uint8_t* src);
+
     void write16(uint32_t adr, const uint16_t data);
     void write16(uint32_t* adr, const uint16_t data);
     void write32(uint32_t* adr, const uint32_t data);
     uint16_t read_road_control();
+    void add_state(SaveState& state);
     void write_road_control(const uint8_t);
+
+    // Interpolation between logic frames.
+    // save_previous: Keep the displayed road scroll, before the next logic frame
+    // interpolate:   Blend the road scroll towards the previous frame, for rendering
+    // restore:       Undo interpolate, once rendered
+    void save_previous();
+    void interpolate(float alpha);
+    void restore();
     void (HWRoad::*render_background)(uint16_t*);
     void (HWRoad::*render_foreground)(uint16_t*);
   
@@ -27,14 +51,24 @@ private:
     static const uint16_t ROAD_RAM_SIZE = 0x1000;
     static const uint16_t rom_size = 0x8000;
 
-    // Decoded road graphics
-    uint8_t roads[0x40200];
+    // Decoded road graphics (roads_data or shared memory)
+    const uint8_t* roads;
+
+    // Private decoded road graphics (NULL if using shared memory)
+    uint8_t* roads_data;
 
     // Two halves of RAM
     uint16_t ram[ROAD_RAM_SIZE / 2];
     uint16_t ramBuff[ROAD_RAM_SIZE / 2];
 
-    void decode_road(const uint8_t*);
+    // Horizontal scroll for both roads (0x200 - 0x5ff)
+    static const uint16_t HSCROLL      = 0x200;
+    static const uint16_t HSCROLL_SIZE = 0x400;
+
+    // Interpolation: road scroll displayed before the last logic frame, and the unblended current scroll
+    uint16_t hscroll_prev[HSCROLL_SIZE];
+    uint16_t hscroll_current[HSCROLL_SIZE];
+
     void render_background_lores(uint16_t*);
     void render_foreground_lores(uint16_t*);
     void render_background_hires(uint16_t*);
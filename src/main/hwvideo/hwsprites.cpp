@@ -1,7 +1,10 @@
+#include <cstring> // memcpy
 #include "video.hpp"
 #include "hwvideo/hwsprites.hpp"
 #include "globals.hpp"
 #include "frontend/config.hpp"
+#include "savestate.hpp"
+#include "hwvideo/interpolate.hpp"
 
 /***************************************************************************
     Video Emulation: OutRun Sprite Rendering Hardware.
@@ -53,10 +56,13 @@
 
 hwsprites::hwsprites()
 {
+    sprites      = NULL;
+    sprites_data = NULL;
 }
 
 hwsprites::~hwsprites()
 {
+    delete[] sprites_data;
 }
 
 void hwsprites::init(const uint8_t* src_sprites)
@@ -64,20 +70,43 @@ void hwsprites::init(const uint8_t* src_sprites)
     reset();
 
     if (src_sprites)
-    {
-        // Convert S16 tiles to a more useable format
-        const uint8_t *spr = src_sprites;
+        decode(src_sprites);
+}
 
-        for (uint32_t i = 0; i < SPRITES_LENGTH; i++)
-        {
-            uint8_t d3 = *spr++;
-            uint8_t d2 = *spr++;
-            uint8_t d1 = *spr++;
-            uint8_t d0 = *spr++;
+void hwsprites::decode(const uint8_t* src_sprites)
+{
+    // Convert S16 tiles to a more useable format
+    const uint8_t *spr = src_sprites;
 
-            sprites[i] = (d0 << 24) | (d1 << 16) | (d2 << 8) | d3;
-        }
+    if (sprites_data == NULL)
+        sprites_data = new uint32_t[SPRITES_LENGTH];
+
+    for (uint32_t i = 0; i < SPRITES_LENGTH; i++)
+    {
+        uint8_t d3 = *spr++;
+        uint8_t d2 = *spr++;
+        uint8_t d1 = *spr++;
+        uint8_t d0 = *spr++;
+
+        sprites_data[i] = (d0 << 24) | (d1 << 16) | (d2 << 8) | d3;
     }
+    sprites = sprites_data;
+}
+
+void hwsprites::set_decoded(const uint32_t* src)
+{
+    if (sprites_data == NULL)
+        sprites_data = new uint32_t[SPRITES_LENGTH];
+
+    memcpy(sprites_data, src, SPRITES_LENGTH * sizeof(uint32_t));
+    sprites = sprites_data;
+}
+
+void hwsprites::use_shared(const uint32_t* src)
+{
+    delete[] sprites_data;
+    sprites_data = NULL;
+    sprites = src;
 }
 
 void hwsprites::reset()
@@ -87,6 +116,14 @@ void hwsprites::reset()
     {
         ram[i] = 0;
         ramBuff[i] = 0;
+        ramPrev[i] = 0;
+    }
+
+    for (uint16_t i = 0; i < SPRITE_ENTRIES; i++)
+    {
+        tags[i] = 0;
+        tagsBuff[i] = 0;
+        tagsPrev[i] = 0;
     }
 }
 
@@ -125,9 +162,29 @@ uint8_t hwsprites::read(const uint16_t adr)
 void hwsprites::write(const uint16_t adr, const uint16_t data)
 {
     ram[adr >> 1] = data;
+
+    // A new sprite entry is unknown until tagged
+    if ((adr & 0xf) == 0)
+        tags[adr >> 4] = 0;
+}
+
+void hwsprites::write_tag(const uint16_t adr, const uint16_t tag)
+{
+    tags[(adr >> 4) & (SPRITE_ENTRIES - 1)] = tag;
 }
 
 // Copy back buffer to main ram, ready for blit
+// Both halves of sprite RAM, and the clipping window
+void hwsprites::add_state(SaveState& state)
+{
+    state.add(ram);
+    state.add(ramBuff);
+    state.add(tags);
+    state.add(tagsBuff);
+    state.add(x1);
+    state.add(x2);
+}
+
 void hwsprites::swap()
 {
     uint16_t *src = (uint16_t *)ram;
@@ -140,6 +197,73 @@ void hwsprites::swap()
         *src++ = *dst;
         *dst++ = temp;
     }
+
+    for (uint16_t i = 0; i < SPRITE_ENTRIES; i++)
+    {
+        uint16_t temp = tags[i];
+        tags[i] = tagsBuff[i];
+        tagsBuff[i] = temp;
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+// Interpolation between logic frames
+// ------------------------------------------------------------------------------------------------
+
+void hwsprites::save_previous()
+{
+    memcpy(ramPrev, ramBuff, sizeof(ramBuff));
+    memcpy(tagsPrev, tagsBuff, sizeof(tagsBuff));
+}
+
+void hwsprites::interpolate(float alpha)
+{
+    memcpy(ramCurrent, ramBuff, sizeof(ramBuff));
+
+    // Previous entry of each tagged sprite. Shadows share the tag of their sprite, so are kept apart.
+    int16_t prev_entry[2][TAGS];
+    memset(prev_entry, 0xff, sizeof(prev_entry));
+
+    for (uint16_t data = 0; data < SPRITE_RAM_SIZE; data += 8)
+    {
+        if ((ramPrev[data+0] & 0x8000) != 0) break;
+
+        const uint16_t tag = tagsPrev[data >> 3];
+        if (tag == 0 || tag >= TAGS || (ramPrev[data+0] & 0x5000) != 0) continue;
+
+        prev_entry[(ramPrev[data+3] >> 14) & 1][tag] = data;
+    }
+
+    for (uint16_t data = 0; data < SPRITE_RAM_SIZE; data += 8)
+    {
+        if ((ramBuff[data+0] & 0x8000) != 0) break;
+
+        const uint16_t tag = tagsBuff[data >> 3];
+        if (tag == 0 || tag >= TAGS || (ramBuff[data+0] & 0x5000) != 0) continue;
+
+        const int16_t prev = prev_entry[(ramBuff[data+3] >> 14) & 1][tag];
+        if (prev < 0) continue;
+
+        const uint16_t* p = ramPrev + prev;
+
+        // Different sprite bank: not the same object
+        if (((p[0] ^ ramBuff[data+0]) & 0x0e00) != 0) continue;
+
+        ramBuff[data+6] = interpolate_field(p[6], ramBuff[data+6], 0xffff, 0x80, alpha); // X
+        ramBuff[data+0] = interpolate_field(p[0], ramBuff[data+0], 0x1ff,  0x40, alpha); // Top
+
+        // Zoom only changes smoothly while the sprite graphic and height are the same
+        if (p[1] == ramBuff[data+1] && (p[5] >> 8) == (ramBuff[data+5] >> 8))
+        {
+            ramBuff[data+3] = interpolate_field(p[3], ramBuff[data+3], 0x7ff, 0x100, alpha);
+            ramBuff[data+4] = interpolate_field(p[4], ramBuff[data+4], 0x7ff, 0x100, alpha);
+        }
+    }
+}
+
+void hwsprites::restore()
+{
+    memcpy(ramBuff, ramCurrent, sizeof(ramBuff));
 }
 
 #if PIXEL_ACCURACY
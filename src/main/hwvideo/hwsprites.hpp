@@ -3,33 +3,69 @@
 #include "stdint.hpp"
 
 class video;
+class SaveState;
 
 class hwsprites
 {
 public:
+    static const uint32_t SPRITES_LENGTH = 0x100000 >> 2;
+
     hwsprites();
     ~hwsprites();
     void init(const uint8_t*);
+
+    // Convert S16 sprites. Independent of the video mode, so can run on a worker thread.
+    void decode(const uint8_t* src_sprites);
+
+    // Converted sprites, for caching between runs
+    const uint32_t* get_decoded() const { return sprites; }
+    void set_decoded(const uint32_t* src);
+
+    // Use converted sprites in shared read-only memory, rather than a private copy
+    void use_shared(const uint32_t* src);
+
     void reset();
     void set_x_clip(bool);
     void swap();
+    void add_state(SaveState& state);
     uint8_t read(const uint16_t adr);
     void write(const uint16_t adr, const uint16_t data);
+    void write_tag(const uint16_t adr, const uint16_t tag);
     void render(const uint8_t);
 
+    // Interpolation between logic frames.
+    // save_previous: Keep the displayed sprites, before the next logic frame
+    // interpolate:   Blend the position and zoom of each sprite towards the previous frame, for rendering
+    // restore:       Undo interpolate, once rendered
+    void save_previous();
+    void interpolate(float alpha);
+    void restore();
+
 private:
     // Clip values.
     uint16_t x1, x2;
 
     // 128 sprites, 16 bytes each (0x400)
     static const uint16_t SPRITE_RAM_SIZE = 128 * 8;
-    static const uint32_t SPRITES_LENGTH = 0x100000 >> 2;
     static const uint16_t COLOR_BASE = 0x800;
 
-    uint32_t sprites[SPRITES_LENGTH]; // Converted sprites
+    const uint32_t* sprites; // Converted sprites (sprites_data or shared memory)
+    uint32_t* sprites_data;  // Private converted sprites (NULL if using shared memory)
     
     // Two halves of RAM
     uint16_t ram[SPRITE_RAM_SIZE];
     uint16_t ramBuff[SPRITE_RAM_SIZE];
+
+    // Identifies the object each sprite was drawn from, so it can be matched between frames (0 = Unknown).
+    // Not part of the hardware: follows the two halves of RAM.
+    static const uint16_t SPRITE_ENTRIES = SPRITE_RAM_SIZE / 8;
+    static const uint16_t TAGS = 0x100;
+    uint16_t tags[SPRITE_ENTRIES];
+    uint16_t tagsBuff[SPRITE_ENTRIES];
+
+    // Interpolation: sprites displayed before the last logic frame, and the unblended current sprites
+    uint16_t ramPrev[SPRITE_RAM_SIZE];
+    uint16_t tagsPrev[SPRITE_ENTRIES];
+    uint16_t ramCurrent[SPRITE_RAM_SIZE];
 };
 
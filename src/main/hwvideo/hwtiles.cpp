@@ -3,6 +3,8 @@
 #include "romloader.hpp"
 #include "hwvideo/hwtiles.hpp"
 #include "frontend/config.hpp"
+#include "savestate.hpp"
+#include "hwvideo/interpolate.hpp"
 #include <cstring>
 
 /***************************************************************************
@@ -81,37 +83,25 @@ hwtiles::hwtiles(void)
     for (int i = 0; i < 2; i++)
         tile_banks[i] = i;
 
+    tiles      = NULL;
+    tiles_data = NULL;
+    memset(patch_slot, 0, sizeof(patch_slot));
+    memset(page_prev, 0, sizeof(page_prev));
+    memset(scroll_x_prev, 0, sizeof(scroll_x_prev));
+    memset(scroll_y_prev, 0, sizeof(scroll_y_prev));
+
     set_x_clamp(CENTRE);
 }
 
 hwtiles::~hwtiles(void)
 {
-
+    delete[] tiles_data;
 }
 
-// Convert S16 tiles to a more useable format
 void hwtiles::init(uint8_t* src_tiles, const bool hires)
 {
     if (src_tiles)
-    {
-        for (int i = 0; i < TILES_LENGTH; i++)
-        {
-            uint8_t p0 = src_tiles[i];
-            uint8_t p1 = src_tiles[i + 0x10000];
-            uint8_t p2 = src_tiles[i + 0x20000];
-
-            uint32_t val = 0;
-
-            for (int ii = 0; ii < 8; ii++) 
-            {
-                uint8_t bit = 7 - ii;
-                uint8_t pix = ((((p0 >> bit)) & 1) | (((p1 >> bit) << 1) & 2) | (((p2 >> bit) << 2) & 4));
-                val = (val << 4) | pix;
-            }
-            tiles[i] = val; // Store converted value
-        }
-        memcpy(tiles_backup, tiles, TILES_LENGTH * sizeof(uint32_t));
-    }
+        decode(src_tiles);
     
     if (hires)
     {
@@ -127,28 +117,79 @@ void hwtiles::init(uint8_t* src_tiles, const bool hires)
     }
 }
 
-// Patch Tileset with new data
+// Convert S16 tiles to a more useable format
+void hwtiles::decode(const uint8_t* src_tiles)
+{
+    if (tiles_data == NULL)
+        tiles_data = new uint32_t[TILES_LENGTH];
+
+    for (int i = 0; i < TILES_LENGTH; i++)
+    {
+        uint8_t p0 = src_tiles[i];
+        uint8_t p1 = src_tiles[i + 0x10000];
+        uint8_t p2 = src_tiles[i + 0x20000];
+
+        uint32_t val = 0;
+
+        for (int ii = 0; ii < 8; ii++) 
+        {
+            uint8_t bit = 7 - ii;
+            uint8_t pix = ((((p0 >> bit)) & 1) | (((p1 >> bit) << 1) & 2) | (((p2 >> bit) << 2) & 4));
+            val = (val << 4) | pix;
+        }
+        tiles_data[i] = val; // Store converted value
+    }
+    tiles = tiles_data;
+}
+
+void hwtiles::set_decoded(const uint32_t* src)
+{
+    if (tiles_data == NULL)
+        tiles_data = new uint32_t[TILES_LENGTH];
+
+    memcpy(tiles_data, src, TILES_LENGTH * sizeof(uint32_t));
+    tiles = tiles_data;
+}
+
+void hwtiles::use_shared(const uint32_t* src)
+{
+    delete[] tiles_data;
+    tiles_data = NULL;
+    tiles = src;
+}
+
+// Patch Tileset with new data.
+// Each patched tile is redirected to a copy in the patch arena, so the original tiles
+// can be restored (and may be read-only). Cost is proportional to the number of tiles patched.
 void hwtiles::patch_tiles(RomLoader* patch)
 {
-    memcpy(tiles_backup, tiles, TILES_LENGTH * sizeof(uint32_t));
+    restore_tiles();
 
-    for (uint32_t i = 0; i < patch->length;)
+    for (uint32_t i = 0; i + 34 <= patch->length;)
     {
-        uint32_t tile_index = patch->read16(&i) << 3;
-        tiles[tile_index++] = patch->read32(&i);
-        tiles[tile_index++] = patch->read32(&i);
-        tiles[tile_index++] = patch->read32(&i);
-        tiles[tile_index++] = patch->read32(&i);
-        tiles[tile_index++] = patch->read32(&i);
-        tiles[tile_index++] = patch->read32(&i);
-        tiles[tile_index++] = patch->read32(&i);
-        tiles[tile_index++] = patch->read32(&i);
+        uint16_t tile = patch->read16(&i) & (NUM_TILES - 1);
+
+        // A tile patched twice reuses its slot
+        if (patch_slot[tile] == 0)
+        {
+            patched_tiles.push_back(tile);
+            patch_slot[tile] = (uint16_t) patched_tiles.size();
+            patch_arena.resize(patched_tiles.size() << 3);
+        }
+
+        uint32_t* dst = &patch_arena[(patch_slot[tile] - 1) << 3];
+        for (int j = 0; j < 8; j++)
+            dst[j] = patch->read32(&i);
     }
 }
 
 void hwtiles::restore_tiles()
 {
-    memcpy(tiles, tiles_backup, TILES_LENGTH * sizeof(uint32_t));
+    for (size_t i = 0; i < patched_tiles.size(); i++)
+        patch_slot[patched_tiles[i]] = 0;
+
+    patched_tiles.clear();
+    patch_arena.clear(); // Capacity is kept for the next patch
 }
 
 // Set Tilemap X Clamp
@@ -175,6 +216,15 @@ void hwtiles::set_x_clamp(const uint16_t props)
     }
 }
 
+// Tile and text RAM, and the state the engine sets directly
+void hwtiles::add_state(SaveState& state)
+{
+    state.add(text_ram);
+    state.add(tile_ram);
+    state.add(tile_banks);
+    state.add(x_clamp);
+}
+
 void hwtiles::update_tile_values()
 {
     for (int i = 0; i < 4; i++)
@@ -186,6 +236,31 @@ void hwtiles::update_tile_values()
     }
 }
 
+void hwtiles::save_previous()
+{
+    update_tile_values();
+
+    for (int i = 0; i < 4; i++)
+    {
+        page_prev[i]     = page[i];
+        scroll_x_prev[i] = scroll_x[i];
+        scroll_y_prev[i] = scroll_y[i];
+    }
+}
+
+void hwtiles::interpolate(float alpha)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        // Row and column scroll (bit 15) isn't blended
+        if (page[i] != page_prev[i] || ((scroll_x[i] | scroll_x_prev[i] | scroll_y[i] | scroll_y_prev[i]) & 0x8000) != 0)
+            continue;
+
+        scroll_x[i] = interpolate_field(scroll_x_prev[i], scroll_x[i], 0x3ff, 0x40, alpha);
+        scroll_y[i] = interpolate_field(scroll_y_prev[i], scroll_y[i], 0x1ff, 0x40, alpha);
+    }
+}
+
 // A quick and dirty debug function to display the contents of tile memory.
 void hwtiles::render_all_tiles(uint16_t* buf)
 {
@@ -325,7 +400,7 @@ void hwtiles::render8x8_tile_mask_lores(
     uint16_t nPaletteOffset) 
 {
     uint32_t nPalette = (nTilePalette << nColourDepth) | nMaskColour;
-    uint32_t* pTileData = tiles + (nTileNumber << 3);
+    const uint32_t* pTileData = tile_data(nTileNumber);
     buf += (StartY * config.s16_width) + StartX;
 
     for (int y = 0; y < 8; y++) 
@@ -368,7 +443,7 @@ void hwtiles::render8x8_tile_mask_clip_lores(
     uint16_t nPaletteOffset) 
 {
     uint32_t nPalette = (nTilePalette << nColourDepth) | nMaskColour;
-    uint32_t* pTileData = tiles + (nTileNumber << 3);
+    const uint32_t* pTileData = tile_data(nTileNumber);
     buf += (StartY * config.s16_width) + StartX;
 
     for (int y = 0; y < 8; y++) 
@@ -419,7 +494,7 @@ void hwtiles::render8x8_tile_mask_hires(
     uint16_t nPaletteOffset) 
 {
     uint32_t nPalette = (nTilePalette << nColourDepth) | nMaskColour;
-    uint32_t* pTileData = tiles + (nTileNumber << 3);
+    const uint32_t* pTileData = tile_data(nTileNumber);
     buf += ((StartY << 1) * config.s16_width) + (StartX << 1);
 
     for (int y = 0; y < 8; y++) 
@@ -462,7 +537,7 @@ void hwtiles::render8x8_tile_mask_clip_hires(
     uint16_t nPaletteOffset) 
 {
     uint32_t nPalette = (nTilePalette << nColourDepth) | nMaskColour;
-    uint32_t* pTileData = tiles + (nTileNumber << 3);
+    const uint32_t* pTileData = tile_data(nTileNumber);
     buf += ((StartY << 1) * config.s16_width) + (StartX << 1);
 
     for (int y = 0; y < 8; y++) 
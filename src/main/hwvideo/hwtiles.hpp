@@ -1,8 +1,10 @@
 #pragma once
 
+#include <vector>
 #include "stdint.hpp"
 
 class RomLoader;
+class SaveState;
 
 class hwtiles
 {
@@ -17,14 +19,34 @@ public:
     uint8_t text_ram[0x1000]; // Text RAM
     uint8_t tile_ram[0x10000]; // Tile RAM
 
+    static const int TILES_LENGTH = 0x10000;
+
     hwtiles(void);
     ~hwtiles(void);
 
     void init(uint8_t* src_tiles, const bool hires);
+
+    // Convert S16 tiles. Independent of the video mode, so can run on a worker thread.
+    void decode(const uint8_t* src_tiles);
+
+    // Converted tiles (without patches), for caching between runs
+    const uint32_t* get_decoded() const { return tiles; }
+    void set_decoded(const uint32_t* src);
+
+    // Use converted tiles in shared read-only memory, rather than a private copy
+    void use_shared(const uint32_t* src);
+
     void patch_tiles(RomLoader* patch);
     void restore_tiles();
     void set_x_clamp(const uint16_t);
+    void add_state(SaveState& state);
     void update_tile_values();
+
+    // Interpolation between logic frames.
+    // save_previous: Keep the displayed scroll values, before the next logic frame
+    // interpolate:   Blend the scroll values from update_tile_values towards the previous frame
+    void save_previous();
+    void interpolate(float alpha);
     void render_tile_layer(uint16_t*, uint8_t, uint8_t);
     void render_text_layer(uint16_t*, uint8_t);
     void render_all_tiles(uint16_t*);
@@ -35,17 +57,35 @@ private:
     // S16 Width, ignoring widescreen related scaling.
     uint16_t s16_width_noscale;
 
-    static const int TILES_LENGTH = 0x10000;
-    uint32_t tiles[TILES_LENGTH];        // Converted tiles
-    uint32_t tiles_backup[TILES_LENGTH]; // Converted tiles (backup without patch)
+    static const uint16_t NUM_TILES = 0x2000; // Length of graphic rom / 24
+
+    const uint32_t* tiles; // Converted tiles without patch (tiles_data or shared memory)
+    uint32_t* tiles_data;  // Private converted tiles (NULL if using shared memory)
+
+    // Tile patch overlay. Patched tiles are redirected to a copy in the patch arena,
+    // so the converted tiles are never modified.
+    uint16_t patch_slot[NUM_TILES];        // Per tile: 0 = unpatched, otherwise arena slot + 1
+    std::vector<uint32_t> patch_arena;     // Patched tile data (8 longs per tile)
+    std::vector<uint16_t> patched_tiles;   // Tiles currently redirected
+
+    // Converted data for a tile, with any patch applied
+    inline const uint32_t* tile_data(uint16_t nTileNumber) const
+    {
+        const uint16_t slot = patch_slot[nTileNumber];
+        return slot ? &patch_arena[(slot - 1) << 3] : tiles + (nTileNumber << 3);
+    }
 
     uint16_t page[4];
     uint16_t scroll_x[4];
     uint16_t scroll_y[4];
 
+    // Scroll values displayed before the last logic frame
+    uint16_t page_prev[4];
+    uint16_t scroll_x_prev[4];
+    uint16_t scroll_y_prev[4];
+
     uint8_t tile_banks[2];
 
-    static const uint16_t NUM_TILES = 0x2000; // Length of graphic rom / 24
     static const uint16_t TILEMAP_COLOUR_OFFSET = 0x1c00;
     
     void (hwtiles::*render8x8_tile_mask)(
@@ -0,0 +1,32 @@
+/***************************************************************************
+    Video Interpolation Helpers.
+
+    When the display runs faster than the game logic, positions held in
+    video RAM are blended between the last two logic frames before each
+    frame is rendered.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#pragma once
+
+#include "stdint.hpp"
+
+// Blend the field of a register selected by mask (which must be 2^n - 1) between two frames.
+// The field wraps within the mask. Other bits are taken from the current value.
+//
+// If the field moved further than limit, the value is treated as a new object rather than
+// movement, and the current value is returned unchanged.
+inline uint16_t interpolate_field(uint16_t prev, uint16_t cur, uint16_t mask, int32_t limit, float alpha)
+{
+    int32_t delta = (cur - prev) & mask;
+    if (delta > (mask >> 1))
+        delta -= mask + 1;
+
+    if (delta > limit || delta < -limit)
+        return cur;
+
+    const int32_t value = prev + (int32_t) (delta * alpha + (delta < 0 ? -0.5f : 0.5f));
+    return (cur & ~mask) | (value & mask);
+}
@@ -6,6 +6,7 @@
 ***************************************************************************/
 
 #include <cstring>
+#include <string>
 #include <iostream>
 
 // SDL Library
@@ -13,6 +14,7 @@
 
 // SDL Specific Code
 #include "sdl2/timer.hpp"
+#include "sdl2/framepacer.hpp"
 #include "sdl2/input.hpp"
 
 #include "video.hpp"
@@ -28,6 +30,14 @@
 #include "engine/oinputs.hpp"
 #include "engine/ooutputs.hpp"
 #include "engine/omusic.hpp"
+#include "engine/audio/osoundint.hpp"
+
+#include "audiorender.hpp"
+#include "utils.hpp"
+#include "startup.hpp"
+#include "savestate.hpp"
+#include "frameskip.hpp"
+#include "realtime.hpp"
 
 // Direct X Haptic Support.
 // Fine to include on non-windows builds as dummy functions used.
@@ -43,6 +53,7 @@ double cannonball::frame_ms    = 0;
 int    cannonball::frame       = 0;
 bool   cannonball::tick_frame  = true;
 int    cannonball::fps_counter = 0;
+int    cannonball::fps_skipped = 0;
 
 // ------------------------------------------------------------------------------------------------
 // Main Variables and Pointers
@@ -51,11 +62,35 @@ Audio cannonball::audio;
 Menu* menu;
 bool pause_engine;
 
+// Offline audio rendering and recording
+static std::string render_wav;
+static std::string render_log;
+static std::string record_log;
+
+// Print the time taken by each start-up phase
+static bool startup_report = false;
+
+// SDL_GetTicks() timestamp of the oldest input event not yet presented (0 = None)
+static Uint32 input_ticks = 0;
+
+// Run-ahead: Frames simulated beyond the current one for display, and the state to rewind to
+static int run_ahead = 0;
+static SaveState run_ahead_state;
+
+// Fast-forward: run the game as fast as allowed, drawing only some frames.
+// Toggled with F4, taking effect from the next frame.
+static bool fast_forward        = false;
+static bool fast_forward_toggle = false;
+
 
 // ------------------------------------------------------------------------------------------------
 
 static void quit_func(int code)
 {
+    config.flush_scores();
+    video.stop_pipeline();
+    oroad.stop_thread();
+    osoundint.record_stop();
     audio.stop_audio();
     input.close_joy();
     forcefeedback::close();
@@ -71,12 +106,30 @@ static void process_events(void)
     // Grab all events from the queue.
     while(SDL_PollEvent(&event))
     {
+        switch(event.type)
+        {
+            case SDL_KEYDOWN:
+            case SDL_KEYUP:
+            case SDL_JOYAXISMOTION:
+            case SDL_JOYBUTTONDOWN:
+            case SDL_JOYBUTTONUP:
+            case SDL_JOYHATMOTION:
+            case SDL_CONTROLLERAXISMOTION:
+            case SDL_CONTROLLERBUTTONDOWN:
+            case SDL_CONTROLLERBUTTONUP:
+                if (input_ticks == 0)
+                    input_ticks = event.common.timestamp;
+                break;
+        }
+
         switch(event.type)
         {
             case SDL_KEYDOWN:
                 // Handle key presses.
                 if (event.key.keysym.sym == SDLK_ESCAPE)
                     state = STATE_QUIT;
+                else if (event.key.keysym.sym == SDLK_F4)
+                    fast_forward_toggle = !event.key.repeat;
                 else
                     input.handle_key_down(&event.key.keysym);
                 break;
@@ -129,15 +182,19 @@ static void process_events(void)
     }
 }
 
-static void tick()
+// Non standard FPS: Determine whether to tick certain logic for the current frame.
+static void set_tick_frame()
 {
-    frame++;
-
-    // Non standard FPS: Determine whether to tick certain logic for the current frame.
     if (config.fps == 60)
         tick_frame = frame & 1;
     else if (config.fps == 120)
         tick_frame = (frame & 3) == 1;
+}
+
+static void tick()
+{
+    frame++;
+    set_tick_frame();
 
     process_events();
 
@@ -207,54 +264,222 @@ static void tick()
     }
 }
 
+// Run-ahead. Simulate frames beyond the current one with the current input, so that the frame shown
+// reflects the input sooner. Returns true if the engine must be rewound once the frame is rendered.
+static bool tick_ahead()
+{
+    if (run_ahead == 0 || state != STATE_GAME || pause_engine)
+        return false;
+
+    run_ahead_state.save();
+
+    const int  frame_real = frame;
+    const bool tick_real  = tick_frame;
+
+    // Sound isn't ticked, so only the real frames are heard
+    outrun.speculative = true;
+    for (int i = 0; i < run_ahead; i++)
+    {
+        frame++;
+        set_tick_frame();
+
+        if (tick_frame)
+        {
+            oinputs.tick();
+            oinputs.do_gear();
+        }
+
+        outrun.tick(tick_frame);
+        if (tick_frame) input.frame_done();
+    }
+
+    outrun.speculative = false;
+
+    frame      = frame_real;
+    tick_frame = tick_real;
+    return true;
+}
+
+static void set_fast_forward(bool on)
+{
+    fast_forward = on;
+    audio.set_fast_forward(on);
+    std::cout << "Fast-forward " << (on ? "on" : "off") << std::endl;
+}
+
+// Fast-forward: run logic frames for one display frame. Only the last will be drawn.
+// Returns the number of logic frames run.
+static int tick_fast_forward()
+{
+    const int speed = config.engine.fast_forward;
+
+    // Uncapped: run for most of the frame period, leaving time to draw and present
+    const double budget_ms = frame_ms * 0.75;
+    Timer timer;
+    timer.start();
+
+    int frames = 0;
+    do
+    {
+        tick();
+        audio.tick();
+        frames++;
+    }
+    while (state != STATE_QUIT && (speed ? frames < speed : timer.get_ticks() < budget_ms));
+
+    return frames;
+}
+
+// Independent display refresh: run the logic frames due since the last display frame, on a fixed timestep.
+// Returns the position between the last two logic frames to display.
+static float tick_fixed(double elapsed_ms)
+{
+    // Most logic frames to run before presenting. Beyond this, the backlog is dropped (e.g. after loading).
+    const static int MAX_TICKS = 4;
+
+    static double accumulator = 0;
+    const double step = frame_ms * audio.adjust_speed();
+
+    accumulator += elapsed_ms;
+    if (accumulator > step * MAX_TICKS)
+        accumulator = step;
+
+    while (accumulator >= step)
+    {
+        if (config.video.interpolate)
+            video.save_previous();
+
+        tick();
+        audio.tick();
+        accumulator -= step;
+    }
+
+    return config.video.interpolate ? (float) (accumulator / step) : 1.0f;
+}
+
 static void main_loop()
 {
     // FPS Counter (If Enabled)
     Timer fps_count;
-    int frame = 0;
+    int frame = 0, skipped = 0;
     fps_count.start();
 
     // General Frame Timing
     bool vsync = config.video.vsync == 1 && video.supports_vsync();
-    Timer frame_time;
-    int t;                              // Actual timing of tick in ms as measured by SDL (ms)
-    double deltatime  = 0;              // Time we want an entire frame to take (ms)
-    int deltaintegral = 0;              // Integer version of above
+    FramePacer pacer;
+    pacer.init(config.video.pacing_spin, config.video.pacing_margin);
+    int stats_frames = 0;
+
+    // Display refresh independent of the game logic (0 = One display frame per logic frame)
+    const int refresh = config.video.refresh;
+
+    // Latency optimised schedule: sleep first, then read input as late as possible and present straight away
+    const bool late_input = config.video.pacing_late != 0 && !refresh;
+
+    // Adaptive frame skipping. An independent refresh rate drops display frames itself.
+    FrameSkip frameskip;
+    frameskip.init(refresh ? 0 : config.video.frameskip);
 
     while (state != STATE_QUIT)
     {
-        frame_time.start();
-        // Tick Engine
-        tick();
+        float alpha = 1.0f;
+        bool rewind = false;
+        bool skip = false;
+        double period = frame_ms;
+        int ticks = 1;
+
+        if (fast_forward_toggle)
+        {
+            fast_forward_toggle = false;
+            set_fast_forward(!fast_forward);
+        }
+
+        if (fast_forward)
+        {
+            // Tick Engine and Sound Chips, for each logic frame run
+            ticks = tick_fast_forward();
+        }
+        else if (refresh)
+        {
+            // Tick Engine and Fill SDL Audio Buffer, for each logic frame due
+            alpha = tick_fixed(pacer.elapsed());
+        }
+        else
+        {
+            skip = frameskip.skip_next();
+
+            if (late_input)
+            {
+                if (vsync)
+                    pacer.latch(frame_ms);
+                else
+                    pacer.wait(period = frame_ms * audio.adjust_speed());
+            }
+
+            // Tick Engine. Run-ahead only affects what is drawn.
+            tick();
+            if (!skip)
+                rewind = tick_ahead();
+        }
 
         // Draw SDL Video
-        video.prepare_frame();
-        video.render_frame();
+        if (skip)
+        {
+            if (vsync)
+                pacer.skipped(frame_ms);
+        }
+        else
+        {
+            video.prepare_frame(alpha);
+            pacer.work_done();
+            video.render_frame();
+            pacer.presented(input_ticks);
+        }
+
+        if (rewind)
+            run_ahead_state.load();
+        input_ticks = 0;
 
         // Fill SDL Audio Buffer For Callback
-        audio.tick();
+        if (!refresh && !fast_forward)
+            audio.tick();
         
-        // Calculate Timings. Cap Frame Rate. Note this might be trumped by V-Sync
-        if (!vsync)
+        // Cap Frame Rate. Note this might be trumped by V-Sync
+        if (!vsync && (!late_input || fast_forward))
+            pacer.wait(period = refresh ? 1000.0 / refresh : frame_ms * audio.adjust_speed());
+
+        if (!refresh)
+        {
+            const double elapsed = pacer.elapsed();
+            if (!fast_forward)
+                frameskip.frame_done(period, elapsed);
+        }
+
+        if (config.video.pacing_stats && ++stats_frames >= (refresh ? refresh : config.fps))
         {
-            deltatime += (frame_ms * audio.adjust_speed());
-            deltaintegral = (int)deltatime;
-            t = frame_time.get_ticks();
-            
-            if (t < deltatime)
-                SDL_Delay((Uint32)(deltatime - t));
-
-            deltatime -= deltaintegral;
+            pacer_stats_t stats;
+            pacer.get_stats(stats);
+            pacer.reset_stats();
+            stats_frames = 0;
+            std::cout << "Pacing: frame " << stats.frame_ms << " ms (max " << stats.frame_max
+                      << " ms), jitter " << stats.jitter_ms << " ms (max " << stats.jitter_max
+                      << " ms), late " << stats.late << ", input latency " << stats.input_ms
+                      << " ms (max " << stats.input_max << " ms)" << std::endl;
         }
 
         if (config.video.fps_count)
         {
-            frame++;
+            // Fast-forward counts the logic frames run
+            if (skip) skipped++;
+            else      frame += ticks;
+
             // One second has elapsed
             if (fps_count.get_ticks() >= 1000)
             {
                 fps_counter = frame;
+                fps_skipped = skipped;
                 frame       = 0;
+                skipped     = 0;
                 fps_count.start();
             }
         }
@@ -278,11 +503,37 @@ static bool parse_command_line(int argc, char* argv[])
             if (!trackloader.set_layout_track(argv[i+1]))
                 return false;
         }
+        else if (strcmp(argv[i], "-render_audio") == 0 && i+1 < argc)
+        {
+            render_wav = argv[i+1];
+        }
+        else if (strcmp(argv[i], "-render_session") == 0 && i+2 < argc)
+        {
+            render_log = argv[i+1];
+            render_wav = argv[i+2];
+        }
+        else if (strcmp(argv[i], "-record_audio") == 0 && i+1 < argc)
+        {
+            record_log = argv[i+1];
+        }
+        else if (strcmp(argv[i], "-startup_report") == 0)
+        {
+            startup_report = true;
+        }
+        else if (strcmp(argv[i], "-fast_forward") == 0)
+        {
+            fast_forward_toggle = true;
+        }
         else if (strcmp(argv[i], "-help") == 0)
         {
             std::cout << "Command Line Options:\n\n" <<
-                         "-cfgfile: Location and name of config.xml\n" <<
-                         "-file   : LayOut Editor track data to load\n" << std::endl;
+                         "-cfgfile       : Location and name of config.xml\n" <<
+                         "-file          : LayOut Editor track data to load\n" <<
+                         "-render_audio  : Render music, effects, engine and traffic to a WAV file, then exit\n" <<
+                         "-render_session: Render a recorded session (log, WAV file), then exit\n" <<
+                         "-record_audio  : Record sound commands to a log, for -render_session\n" <<
+                         "-startup_report: Print the time taken by each start-up phase\n" <<
+                         "-fast_forward  : Start in fast-forward (F4 toggles)\n" << std::endl;
             return false;
         }
     }
@@ -291,56 +542,130 @@ static bool parse_command_line(int argc, char* argv[])
 
 int main(int argc, char* argv[])
 {
+    Startup startup;
+
     // Parse command line arguments (config file location, LayOut data) 
     bool ok = parse_command_line(argc, argv);
 
     if (ok)
-    {
-        config.load(); // Load config.XML file
-        ok = roms.load_revb_roms(config.sound.fix_samples);
-    }
+        startup.run("config", []() { config.load(); return true; }); // Load config.XML file
     if (!ok)
     {
         quit_func(1);
         return 0;
     }
 
+    // ROMs are read, checked and decoded on worker threads, while SDL initializes on this thread
+    const int load_roms = startup.start("load roms", []()
+    {
+        const bool cached = video.open_cache(&roms);
+        return roms.load_revb_roms(config.sound.fix_samples, !cached, !(cached && config.data.shared_assets));
+    });
+
+    // Render audio offline, without initializing SDL
+    if (!render_wav.empty())
+    {
+        if (!startup.wait(load_roms))
+            return 1;
+
+        AudioRender render;
+        ok = render_log.empty() ? render.render_script(render_wav) : render.render_session(render_log, render_wav);
+        return ok ? 0 : 1;
+    }
+
+    const int decode = startup.start("decode video", []() { video.decode(&roms); return true; }, { load_roms });
+
+    // Load patched widescreen tilemaps
+    startup.start("widescreen maps", []()
+    {
+        if (!omusic.load_widescreen_map(config.data.res_path))
+            std::cout << "Unable to load widescreen tilemaps" << std::endl;
+        return true;
+    });
+
     // Load gamecontrollerdb.txt mappings
-    if (SDL_GameControllerAddMappingsFromFile((config.data.res_path + "gamecontrollerdb.txt").c_str()) == -1)
-        std::cout << "Unable to load controller mapping" << std::endl;
+    startup.run("controller db", []()
+    {
+        if (SDL_GameControllerAddMappingsFromFile((config.data.res_path + "gamecontrollerdb.txt").c_str()) == -1)
+            std::cout << "Unable to load controller mapping" << std::endl;
+        return true;
+    });
 
     // Initialize timer and video systems
-    if (SDL_Init(SDL_INIT_TIMER | SDL_INIT_VIDEO | SDL_INIT_JOYSTICK | SDL_INIT_GAMECONTROLLER | SDL_INIT_HAPTIC) == -1)
+    if (!startup.run("sdl init", []() { return SDL_Init(SDL_INIT_TIMER | SDL_INIT_VIDEO | SDL_INIT_JOYSTICK | SDL_INIT_GAMECONTROLLER | SDL_INIT_HAPTIC) != -1; }))
     {
         std::cerr << "SDL Initialization Failed: " << SDL_GetError() << std::endl;
         return 1;
     }
 
-    // Load patched widescreen tilemaps
-    if (!omusic.load_widescreen_map(config.data.res_path))
-        std::cout << "Unable to load widescreen tilemaps" << std::endl;
+    // Create window and renderer. Not until the ROMs have loaded, so no window opens if they are missing.
+    ok = startup.run("video mode", []() { return video.set_video_mode(&config.video) != 0; }, { load_roms });
+
+    // Sound requires the PCM ROM
+    ok &= startup.run("sound init", []() { config.set_fps(config.video.fps); return true; }, { load_roms });
+
+    // Initialize SDL Video, once the graphics are decoded
+    ok &= startup.run("video layers", []() { return video.init_layers(&roms) != 0; }, { decode });
 
-    // Initialize SDL Video
-    config.set_fps(config.video.fps);
-    if (!video.init(&roms, &config.video))
+    if (!ok)
+    {
+        startup.wait_all();
         quit_func(1);
+    }
 
     // Initialize SDL Audio
-    audio.init();
+    startup.run("audio init", []() { audio.init(); return true; });
+
+    if (!record_log.empty() && !osoundint.record_start(record_log.c_str()))
+        std::cout << "Unable to record sound to: " << record_log << std::endl;
+
+    // Run-ahead. Not used when recording, as the recording must follow the real frames only.
+    // Nor with an independent display refresh, where the logic frames are decoupled from presentation.
+    run_ahead = record_log.empty() && !config.video.refresh ? config.engine.run_ahead : 0;
+    if (config.engine.run_ahead && config.video.refresh)
+        std::cout << "Run-ahead is not used with an independent display refresh rate" << std::endl;
+    if (run_ahead)
+    {
+        outrun.add_state(run_ahead_state);
+        video.add_state(run_ahead_state);
+        run_ahead_state.add(input.keys_old);
+    }
 
     state = config.menu.enabled ? STATE_INIT_MENU : STATE_INIT_GAME;
 
     // Initalize SDL Controls
-    input.init(config.controls.pad_id,
-               config.controls.keyconfig, config.controls.padconfig, 
-               config.controls.analog,    config.controls.axis, config.controls.invert, config.controls.asettings);
-
-    if (config.controls.haptic) 
-        config.controls.haptic = forcefeedback::init(config.controls.max_force, config.controls.min_force, config.controls.force_duration);
+    startup.run("input init", []()
+    {
+        input.init(config.controls.pad_id,
+                   config.controls.keyconfig, config.controls.padconfig, 
+                   config.controls.analog,    config.controls.axis, config.controls.invert, config.controls.asettings);
+
+        if (config.controls.haptic) 
+            config.controls.haptic = forcefeedback::init(config.controls.max_force, config.controls.min_force, config.controls.force_duration);
+        return true;
+    });
         
     // Populate menus
-    menu = new Menu();
-    menu->populate();
+    startup.run("menu", []()
+    {
+        menu = new Menu();
+        menu->populate();
+        return true;
+    });
+
+    if (startup_report)
+        startup.report();
+    else
+        startup.wait_all();
+
+    if (config.data.memory_report)
+        Utils::report_rss("start-up");
+
+    // Real-time scheduling. Applied once start-up is complete, so it covers the game loop only.
+    realtime::apply_thread("main", config.realtime.main_core, config.realtime.policy, config.realtime.main_priority, true);
+    if (config.realtime.mlock)
+        realtime::lock_memory();
+
     main_loop();  // Loop until we quit the app
 
     // Never Reached
@@ -19,6 +19,9 @@ namespace cannonball
     // FPS Counter
     extern int fps_counter;
 
+    // Frames skipped in the last second, by adaptive frame skipping
+    extern int fps_skipped;
+
     // Engine Master State
     extern int state;
     
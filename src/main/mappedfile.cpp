@@ -0,0 +1,125 @@
+/***************************************************************************
+    Memory Mapped File.
+
+    Maps a file read-only into memory. Pages are loaded on demand by the
+    OS and shared between processes mapping the same file.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "mappedfile.hpp"
+
+MappedFile::MappedFile()
+{
+    data    = NULL;
+    length  = 0;
+#ifdef _WIN32
+    file    = INVALID_HANDLE_VALUE;
+    mapping = NULL;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const char* filename)
+{
+    close();
+
+    file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        close();
+        return false;
+    }
+
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL)
+    {
+        close();
+        return false;
+    }
+
+    data = (const uint8_t*) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == NULL)
+    {
+        close();
+        return false;
+    }
+
+    length = (size_t) size.QuadPart;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (data != NULL)
+        UnmapViewOfFile(data);
+    if (mapping != NULL)
+        CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE)
+        CloseHandle(file);
+
+    data    = NULL;
+    length  = 0;
+    file    = INVALID_HANDLE_VALUE;
+    mapping = NULL;
+}
+
+#else
+
+bool MappedFile::open(const char* filename)
+{
+    close();
+
+    int fd = ::open(filename, O_RDONLY);
+    if (fd == -1)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    void* addr = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // Mapping remains valid after the descriptor is closed
+
+    if (addr == MAP_FAILED)
+        return false;
+
+    data   = (const uint8_t*) addr;
+    length = (size_t) st.st_size;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (data != NULL)
+        munmap((void*) data, length);
+
+    data   = NULL;
+    length = 0;
+}
+
+#endif
@@ -0,0 +1,42 @@
+/***************************************************************************
+    Memory Mapped File.
+
+    Maps a file read-only into memory. Pages are loaded on demand by the
+    OS and shared between processes mapping the same file.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include "stdint.hpp"
+
+class MappedFile
+{
+public:
+    // Start of mapped file (NULL if not open)
+    const uint8_t* data;
+
+    // Size of file in bytes
+    size_t length;
+
+    MappedFile();
+    ~MappedFile();
+
+    bool open(const char* filename);
+    void close();
+
+    bool is_open() const { return data != NULL; }
+
+private:
+    // Not copyable: the mapping is owned by this object
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+#ifdef _WIN32
+    void* file;
+    void* mapping;
+#endif
+};
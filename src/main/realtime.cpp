@@ -0,0 +1,190 @@
+/***************************************************************************
+    Real-Time Scheduling Controls.
+
+    For dedicated cabinets, where the game competes with other processes:
+    - Pin threads to chosen cores.
+    - Run threads with a real-time scheduling policy and priority.
+    - Lock memory, so the game isn't stalled by page faults.
+
+    Each setting falls back to normal behaviour if the process lacks the
+    privilege to apply it. What was applied is printed to the console.
+
+    Linux only. Other platforms report that the settings are unsupported.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include <iostream>
+#include <sstream>
+
+#include "realtime.hpp"
+
+//-----------------------------------------------------------------------------
+// Dummy Functions For Non-Linux Builds
+//-----------------------------------------------------------------------------
+#ifndef __linux__
+namespace realtime
+{
+    void apply_thread(const char* name, int core, int /*policy*/, int priority, bool /*inherited*/)
+    {
+        if (core >= 0 || priority > 0)
+            std::cout << "Real-time: " << name << " thread: Not supported on this platform" << std::endl;
+    }
+
+    void reset_thread(const char* /*name*/, bool /*keep_priority*/)
+    {
+    }
+
+    void lock_memory()
+    {
+        std::cout << "Real-time: Memory locking not supported on this platform" << std::endl;
+    }
+};
+
+//-----------------------------------------------------------------------------
+// Linux Code Below
+//-----------------------------------------------------------------------------
+#else
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+namespace realtime
+{
+    // Cores the process started with. Saved during static initialisation, before any thread is created or pinned.
+    static cpu_set_t original_cores;
+    static bool original_saved = sched_getaffinity(0, sizeof(original_cores), &original_cores) == 0;
+
+    // Settings applied to a thread whose new threads inherit them (-1 = None).
+    // Atomic, as the audio thread may already be running when they are set.
+    static std::atomic<int> inherited_core(-1);
+    static std::atomic<int> inherited_sched(-1);
+    static std::atomic<int> inherited_priority(0);
+
+    void apply_thread(const char* name, int core, int policy, int priority, bool inherited)
+    {
+        if (core < 0 && priority <= 0)
+            return;
+
+        std::ostringstream report;
+        report << "Real-time: " << name << " thread:";
+
+        if (core >= 0)
+        {
+            int err = EINVAL;
+            if (core < CPU_SETSIZE)
+            {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(core, &set);
+                err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+            }
+
+            if (err == 0)
+            {
+                report << " core " << core << ".";
+                if (inherited)
+                    inherited_core = core;
+            }
+            else
+                report << " core " << core << " not applied (" << strerror(err) << "), running on any core.";
+        }
+
+        if (priority > 0)
+        {
+            const int sched        = policy == POLICY_RR ? SCHED_RR : SCHED_FIFO;
+            const char* sched_name = policy == POLICY_RR ? "SCHED_RR" : "SCHED_FIFO";
+
+            // Clamp to the range supported by the policy
+            const int min = sched_get_priority_min(sched);
+            const int max = sched_get_priority_max(sched);
+            if (priority < min)      priority = min;
+            else if (priority > max) priority = max;
+
+            sched_param param;
+            param.sched_priority = priority;
+            const int err = pthread_setschedparam(pthread_self(), sched, &param);
+
+            if (err == 0)
+            {
+                report << " " << sched_name << " priority " << priority << ".";
+                if (inherited)
+                {
+                    inherited_priority = priority;
+                    inherited_sched    = sched;
+                }
+            }
+            else
+                report << " " << sched_name << " not applied (" << strerror(err) << "), using normal scheduling.";
+        }
+
+        std::cout << report.str() << std::endl;
+    }
+
+    void reset_thread(const char* name, bool keep_priority)
+    {
+        std::ostringstream report;
+        report << "Real-time: " << name << " thread:";
+        bool changed = false;
+
+        // Only undo the settings if the thread still has exactly those it inherited
+        const int core = inherited_core;
+        if (core >= 0 && original_saved)
+        {
+            cpu_set_t set;
+            if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0 &&
+                CPU_COUNT(&set) == 1 && CPU_ISSET(core, &set) && !CPU_EQUAL(&set, &original_cores))
+            {
+                const int err = pthread_setaffinity_np(pthread_self(), sizeof(original_cores), &original_cores);
+                if (err == 0)
+                    report << " original cores.";
+                else
+                    report << " original cores not restored (" << strerror(err) << ").";
+                changed = true;
+            }
+        }
+
+        const int sched_inherited = inherited_sched;
+        if (!keep_priority && sched_inherited != -1)
+        {
+            int sched;
+            sched_param param;
+            if (pthread_getschedparam(pthread_self(), &sched, &param) == 0 &&
+                sched == sched_inherited && param.sched_priority == inherited_priority)
+            {
+                param.sched_priority = 0;
+                const int err = pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+                if (err == 0)
+                    report << " normal scheduling.";
+                else
+                    report << " normal scheduling not restored (" << strerror(err) << ").";
+                changed = true;
+            }
+        }
+
+        if (changed)
+            std::cout << report.str() << std::endl;
+    }
+
+    void lock_memory()
+    {
+        // Future allocations are only locked if the lock limit can't be reached. Otherwise, they would fail once it was.
+        struct rlimit limit;
+        const bool unlimited = geteuid() == 0 ||
+                               (getrlimit(RLIMIT_MEMLOCK, &limit) == 0 && limit.rlim_cur == RLIM_INFINITY);
+
+        if (mlockall(unlimited ? (MCL_CURRENT | MCL_FUTURE) : MCL_CURRENT) == 0)
+            std::cout << "Real-time: Memory locked" << (unlimited ? "." : " (current allocations only).") << std::endl;
+        else
+            std::cout << "Real-time: Memory not locked (" << strerror(errno) << ")." << std::endl;
+    }
+};
+
+#endif
@@ -0,0 +1,45 @@
+/***************************************************************************
+    Real-Time Scheduling Controls.
+
+    For dedicated cabinets, where the game competes with other processes:
+    - Pin threads to chosen cores.
+    - Run threads with a real-time scheduling policy and priority.
+    - Lock memory, so the game isn't stalled by page faults.
+
+    Each setting falls back to normal behaviour if the process lacks the
+    privilege to apply it. What was applied is printed to the console.
+
+    Linux only. Other platforms report that the settings are unsupported.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#pragma once
+
+namespace realtime
+{
+    enum
+    {
+        POLICY_NORMAL = 0,
+        POLICY_FIFO   = 1,
+        POLICY_RR     = 2,
+    };
+
+    // Apply settings to the calling thread.
+    // name:      Thread name, for the report
+    // core:      Core to run on (-1 = Any)
+    // policy:    Scheduling policy (POLICY_FIFO or POLICY_RR)
+    // priority:  Real-time priority (0 = Leave the scheduling unchanged)
+    // inherited: Threads created by the calling thread afterwards inherit the settings. reset_thread undoes them.
+    extern void apply_thread(const char* name, int core, int policy, int priority, bool inherited = false);
+
+    // Undo settings the calling thread inherited from apply_thread: return it to the cores the process
+    // started with and, unless keep_priority is set, normal scheduling. Settings from anywhere else
+    // (e.g. taskset or chrt) are left alone. Call at the start of threads that may be created afterwards.
+    // keep_priority: Another thread waits on this one, so a lower priority would hold it up.
+    extern void reset_thread(const char* name, bool keep_priority = false);
+
+    // Lock the memory of the process into RAM
+    extern void lock_memory();
+};
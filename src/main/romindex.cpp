@@ -0,0 +1,211 @@
+/***************************************************************************
+    ROM Index.
+
+    Index of the files in the ROM directory by CRC32 value, used by the
+    CRC32 based ROM loader.
+
+    Files are hashed in full, in parallel, using memory mapped reads. The
+    results are cached in a file keyed by path, size and modification time,
+    so subsequent runs only hash files that have changed.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+#include <boost/crc.hpp> // CRC Checking via Boost library.
+
+#include "romindex.hpp"
+#include "mappedfile.hpp"
+
+#ifdef _MSC_VER
+#include "windirent.h"
+#else
+#include <dirent.h>
+#endif
+
+RomIndex::RomIndex()
+{
+}
+
+RomIndex::~RomIndex()
+{
+}
+
+bool RomIndex::build(const std::string& path, const std::string& cache_file)
+{
+    files.clear();
+    by_crc.clear();
+
+    if (!cache_file.empty())
+        load_cache(cache_file);
+
+    DIR* dir;
+    struct dirent* ent;
+
+    if ((dir = opendir(path.c_str())) == NULL)
+        return false;
+
+    // Files in directory order, and the ones that need hashing
+    std::vector<std::string> names;
+    std::vector<size_t> todo;
+    std::unordered_map<std::string, entry_t> found;
+
+    while ((ent = readdir(dir)) != NULL)
+    {
+        std::string file = path + ent->d_name;
+
+        struct stat st;
+        if (stat(file.c_str(), &st) != 0 || (st.st_mode & S_IFMT) != S_IFREG)
+            continue;
+
+        entry_t entry;
+        entry.size  = (uint64_t) st.st_size;
+        entry.mtime = (int64_t) st.st_mtime;
+        entry.crc   = 0;
+
+        auto cached = files.find(file);
+        if (cached != files.end() && cached->second.size == entry.size && cached->second.mtime == entry.mtime)
+            entry.crc = cached->second.crc;
+        else
+            todo.push_back(names.size());
+
+        names.push_back(file);
+        found[file] = entry;
+    }
+    closedir(dir);
+
+    // Hash new and changed files across all cores
+    std::vector<char> failed(names.size(), 0);
+
+    if (!todo.empty())
+    {
+        std::vector<uint32_t> crcs(todo.size());
+        std::atomic<size_t> next(0);
+
+        auto worker = [&]()
+        {
+            for (size_t i = next++; i < todo.size(); i = next++)
+            {
+                if (!crc_file(names[todo[i]], crcs[i]))
+                    failed[todo[i]] = 1;
+            }
+        };
+
+        size_t thread_count = std::thread::hardware_concurrency();
+        if (thread_count < 1)           thread_count = 1;
+        if (thread_count > todo.size()) thread_count = todo.size();
+
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < thread_count; i++)
+            threads.push_back(std::thread(worker));
+        worker();
+        for (size_t i = 0; i < threads.size(); i++)
+            threads[i].join();
+
+        for (size_t i = 0; i < todo.size(); i++)
+            found[names[todo[i]]].crc = crcs[i];
+    }
+
+    // Entries for other directories are kept in the cache. Entries for this directory are replaced.
+    bool changed = !todo.empty();
+    for (auto it = files.begin(); it != files.end();)
+    {
+        if (it->first.compare(0, path.length(), path) == 0 && it->first.find_first_of("/\\", path.length()) == std::string::npos)
+        {
+            changed |= found.find(it->first) == found.end();
+            it = files.erase(it);
+        }
+        else
+            ++it;
+    }
+
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        if (failed[i])
+            continue;
+
+        const entry_t& entry = found[names[i]];
+        files[names[i]] = entry;
+        by_crc.insert({ entry.crc, names[i] }); // First file found with a CRC is used
+    }
+
+    if (changed && !cache_file.empty())
+        save_cache(cache_file);
+
+    return true;
+}
+
+bool RomIndex::find(uint32_t crc, std::string& filename) const
+{
+    auto search = by_crc.find(crc);
+    if (search == by_crc.end())
+        return false;
+
+    filename = search->second;
+    return true;
+}
+
+bool RomIndex::crc_file(const std::string& filename, uint32_t& crc)
+{
+    boost::crc_32_type result;
+
+    struct stat st;
+    if (stat(filename.c_str(), &st) == 0 && st.st_size == 0)
+    {
+        crc = result.checksum(); // Empty files can't be mapped
+        return true;
+    }
+
+    MappedFile file;
+    if (!file.open(filename.c_str()))
+        return false;
+
+    result.process_bytes(file.data, file.length);
+    crc = result.checksum();
+    return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Cache File
+// Format: Version line, then one line per file of: crc size mtime path
+// ------------------------------------------------------------------------------------------------
+
+void RomIndex::load_cache(const std::string& cache_file)
+{
+    std::ifstream src(cache_file.c_str());
+    if (!src)
+        return;
+
+    std::string line;
+    uint32_t version = 0;
+    if (!std::getline(src, line) || sscanf(line.c_str(), "romindex %u", &version) != 1 || version != CACHE_VERSION)
+        return;
+
+    while (std::getline(src, line))
+    {
+        std::istringstream fields(line);
+        entry_t entry;
+        std::string file;
+
+        if (fields >> std::hex >> entry.crc >> std::dec >> entry.size >> entry.mtime && fields.get() == ' ' && std::getline(fields, file))
+            files[file] = entry;
+    }
+}
+
+void RomIndex::save_cache(const std::string& cache_file)
+{
+    std::ofstream dst(cache_file.c_str());
+    if (!dst)
+        return;
+
+    dst << "romindex " << CACHE_VERSION << "\n";
+    for (auto it = files.begin(); it != files.end(); ++it)
+        dst << std::hex << it->second.crc << std::dec << " " << it->second.size << " " << it->second.mtime << " " << it->first << "\n";
+}
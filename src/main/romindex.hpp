@@ -0,0 +1,55 @@
+/***************************************************************************
+    ROM Index.
+
+    Index of the files in the ROM directory by CRC32 value, used by the
+    CRC32 based ROM loader.
+
+    Files are hashed in full, in parallel, using memory mapped reads. The
+    results are cached in a file keyed by path, size and modification time,
+    so subsequent runs only hash files that have changed.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include "stdint.hpp"
+
+class RomIndex
+{
+public:
+    RomIndex();
+    ~RomIndex();
+
+    // Index the files in a directory. Returns false if the directory cannot be read.
+    // cache_file: File to load and save previously calculated CRC values (empty to disable)
+    bool build(const std::string& path, const std::string& cache_file);
+
+    // Find the file with the given CRC. Returns false if not present.
+    bool find(uint32_t crc, std::string& filename) const;
+
+    bool empty() const { return by_crc.empty(); }
+
+private:
+    const static uint32_t CACHE_VERSION = 1;
+
+    struct entry_t
+    {
+        uint64_t size;
+        int64_t  mtime;
+        uint32_t crc;
+    };
+
+    // Files by full path
+    std::unordered_map<std::string, entry_t> files;
+
+    // Files by CRC
+    std::unordered_map<uint32_t, std::string> by_crc;
+
+    void load_cache(const std::string& cache_file);
+    void save_cache(const std::string& cache_file);
+    static bool crc_file(const std::string& filename, uint32_t& crc);
+};
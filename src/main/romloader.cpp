@@ -11,26 +11,16 @@
 #include <iostream>
 #include <fstream>
 #include <cstddef>       // for std::size_t
+#include <cstring>
 #include <boost/crc.hpp> // CRC Checking via Boost library.
-#include <unordered_map>
 
 #include "stdint.hpp"
 #include "romloader.hpp"
+#include "romindex.hpp"
 #include "frontend/config.hpp"
 
-// In order to get a cross-platform directory listing I'm using a Visual Studio
-// version of Linux's Dirent from here: https://github.com/tronkko/dirent
-//
-// This appears to be the most lightweight solution available without resorting 
-// to enormous boost libraries or switching to C++17.
-#ifdef _MSC_VER
-#include "windirent.h"
-#else
-#include <dirent.h>
-#endif
-
-// Unordered Map to store contents of directory by CRC 32 value. Similar to Hashmap.
-static std::unordered_map<int, std::string> map;
+// Contents of ROM directory by CRC 32 value.
+static RomIndex map;
 static bool map_created;
 
 
@@ -39,11 +29,12 @@ RomLoader::RomLoader()
     rom = NULL;
     map_created = false;
     loaded = false;
+    mapped = false;
 }
 
 RomLoader::~RomLoader()
 {
-    if (rom != NULL)
+    if (rom != NULL && !mapped)
         delete[] rom;
 }
 
@@ -56,10 +47,35 @@ void RomLoader::init(const uint32_t length)
     rom = new uint8_t[length];
 }
 
+// Use ROM data that has already been loaded into shared memory.
+// The memory is read-only: call make_private() before writing to it.
+void RomLoader::use_shared(const uint8_t* data, const uint32_t length)
+{
+    unload();
+    this->length = length;
+    rom    = const_cast<uint8_t*>(data);
+    mapped = true;
+    loaded = true;
+}
+
+// Replace a shared view with a private, writable copy
+void RomLoader::make_private(void)
+{
+    if (!mapped)
+        return;
+
+    uint8_t* copy = new uint8_t[length];
+    memcpy(copy, rom, length);
+    rom    = copy;
+    mapped = false;
+}
+
 void RomLoader::unload(void)
 {
-    delete[] rom;
-    rom = NULL;
+    if (!mapped)
+        delete[] rom;
+    rom    = NULL;
+    mapped = false;
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -112,8 +128,9 @@ int RomLoader::load_rom(const char* filename, const int offset, const int length
 }
 
 // --------------------------------------------------------------------------------------------
-// Create Unordered Map of files in ROM directory by CRC32 value
+// Create Index of files in ROM directory by CRC32 value
 // This should be faster than brute force searching every file in the directory every time.
+// CRC values are cached between runs, so only new or changed files are hashed.
 // --------------------------------------------------------------------------------------------
 
 int RomLoader::create_map()
@@ -121,41 +138,16 @@ int RomLoader::create_map()
     map_created = true;
 
     std::string path = config.data.rom_path;
-    DIR* dir;
-    struct dirent* ent;
 
-    if ((dir = opendir(path.c_str())) == NULL)
+    if (!map.build(path, config.data.file_rom_index))
     {
         std::cout << "Warning: Could not open ROM directory - " << path << std::endl;
         return 1; // Failure (Could not open directory)
     }
 
-    // Iterate all files in directory
-    while ((ent = readdir(dir)) != NULL)
-    {
-        std::string file = path + ent->d_name;
-        std::ifstream src(file, std::ios::in | std::ios::binary);
-
-        if (!src) continue;
-
-        // Read file
-        char* buffer = new char[length];
-        src.read(buffer, length);
-
-        // Check CRC on file
-        boost::crc_32_type result;
-        result.process_bytes(buffer, (size_t)src.gcount());
-
-        // Insert file into MAP between CRC and filename
-        map.insert({ result.checksum(), file });
-        delete[] buffer;
-        src.close();
-    }
-
     if (map.empty())
         std::cout << "Warning: Could not create CRC32 Map. Did you copy the ROM files into the directory? " << std::endl;
 
-    closedir(dir);
     return 0; //success
 }
 
@@ -173,10 +165,10 @@ int RomLoader::load_crc32(const char* debug, const int offset, const int length,
     if (map.empty())
         return 1;
 
-    auto search = map.find(expected_crc);
+    std::string file;
 
     // Cannot find file by CRC value in map
-    if (search == map.end())
+    if (!map.find(expected_crc, file))
     {
         if (verbose) std::cout << "Unable to locate rom in path: " << config.data.rom_path << " possible name: " << debug << " crc32: 0x" << std::hex << expected_crc << std::endl;
         loaded = false;
@@ -184,8 +176,6 @@ int RomLoader::load_crc32(const char* debug, const int offset, const int length,
     }
 
     // Correct ROM found
-    std::string file = search->second;
-
     std::ifstream src(file, std::ios::in | std::ios::binary);
     if (!src)
     {
@@ -237,6 +227,12 @@ int RomLoader::load_binary(const char* filename)
     return 0; // success
 }
 
+void RomLoader::read_mismatch(uint32_t addr, int size, uint32_t fast, uint32_t expected)
+{
+    std::cout << "ROM read" << size << " mismatch at 0x" << std::hex << addr << ": 0x" << fast
+              << " expected 0x" << expected << std::dec << std::endl;
+}
+
 int RomLoader::filesize(const char* filename)
 {
     std::ifstream in(filename, std::ifstream::in | std::ifstream::binary);
@@ -10,6 +10,41 @@
 
 #pragma once
 
+#include <cstring> // memcpy
+#include "stdint.hpp"
+
+// ------------------------------------------------------------------------------------------------
+// Conversion from ROM byte order to native byte order
+// ------------------------------------------------------------------------------------------------
+
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    #define ROM_FROM_BE16(x) (x)
+    #define ROM_FROM_BE32(x) (x)
+    #define ROM_FROM_LE16(x) __builtin_bswap16(x)
+#elif defined(__GNUC__)
+    #define ROM_FROM_BE16(x) __builtin_bswap16(x)
+    #define ROM_FROM_BE32(x) __builtin_bswap32(x)
+    #define ROM_FROM_LE16(x) (x)
+#elif defined(_MSC_VER)
+    #include <stdlib.h>
+    #define ROM_FROM_BE16(x) _byteswap_ushort(x)
+    #define ROM_FROM_BE32(x) _byteswap_ulong(x)
+    #define ROM_FROM_LE16(x) (x)
+#else
+    #error "Unknown compiler: define the ROM byte order conversions"
+#endif
+
+// Debug: Cross-check every fast read against the original byte-wise read
+#ifdef ROM_READ_CHECK
+    #define ROM_READ_CHECK16(addr, fast, expected) \
+        if ((fast) != (uint16_t) (expected)) read_mismatch(addr, 16, fast, expected)
+    #define ROM_READ_CHECK32(addr, fast, expected) \
+        if ((fast) != (uint32_t) (expected)) read_mismatch(addr, 32, fast, expected)
+#else
+    #define ROM_READ_CHECK16(addr, fast, expected)
+    #define ROM_READ_CHECK32(addr, fast, expected)
+#endif
+
 class RomLoader
 {
 
@@ -24,9 +59,14 @@ public:
     // Successfully loaded
     bool loaded;
 
+    // rom is a read-only view of shared memory, rather than a private copy
+    bool mapped;
+
     RomLoader();
     ~RomLoader();
     void init(uint32_t);
+    void use_shared(const uint8_t* data, uint32_t length);
+    void make_private(void);
 
     int (RomLoader::*load)(const char*, const int, const int, const int, const uint8_t, const bool);
     int load_rom(const char* filename, const int offset, const int length, const int expected_crc, const uint8_t mode = NORMAL, const bool verbose = true);
@@ -36,18 +76,19 @@ public:
 
     // ----------------------------------------------------------------------------
     // Used by translated 68000 Code
+    // Each read is a single (unaligned) load, byte-swapped to native order if required.
     // ----------------------------------------------------------------------------
 
     inline uint32_t read32(uint32_t* addr)
     {    
-        uint32_t data = (rom[*addr] << 24) | (rom[*addr+1] << 16) | (rom[*addr+2] << 8) | (rom[*addr+3]);
+        uint32_t data = read32(*addr);
         *addr += 4;
         return data;
     }
 
     inline uint16_t read16(uint32_t* addr)
     {
-        uint16_t data = (rom[*addr] << 8) | (rom[*addr+1]);
+        uint16_t data = read16(*addr);
         *addr += 2;
         return data;
     }
@@ -59,12 +100,20 @@ public:
 
     inline uint32_t read32(uint32_t addr)
     {    
-        return (rom[addr] << 24) | (rom[addr+1] << 16) | (rom[addr+2] << 8) | rom[addr+3];
+        uint32_t data;
+        memcpy(&data, rom + addr, sizeof(data));
+        data = ROM_FROM_BE32(data);
+        ROM_READ_CHECK32(addr, data, (rom[addr] << 24) | (rom[addr+1] << 16) | (rom[addr+2] << 8) | rom[addr+3]);
+        return data;
     }
 
     inline uint16_t read16(uint32_t addr)
     {
-        return (rom[addr] << 8) | rom[addr+1];
+        uint16_t data;
+        memcpy(&data, rom + addr, sizeof(data));
+        data = ROM_FROM_BE16(data);
+        ROM_READ_CHECK16(addr, data, (rom[addr] << 8) | rom[addr+1]);
+        return data;
     }
 
     inline uint8_t read8(uint32_t addr)
@@ -79,7 +128,7 @@ public:
 
     inline uint16_t read16(uint16_t* addr)
     {
-        uint16_t data = (rom[*addr+1] << 8) | (rom[*addr]);
+        uint16_t data = read16(*addr);
         *addr += 2;
         return data;
     }
@@ -91,7 +140,11 @@ public:
 
     inline uint16_t read16(uint16_t addr)
     {
-        return (rom[addr+1] << 8) | rom[addr];
+        uint16_t data;
+        memcpy(&data, rom + addr, sizeof(data));
+        data = ROM_FROM_LE16(data);
+        ROM_READ_CHECK16(addr, data, (rom[addr+1] << 8) | rom[addr]);
+        return data;
     }
 
     inline uint8_t read8(uint16_t addr)
@@ -99,6 +152,9 @@ public:
         return rom[addr];
     }
 
+    // Report a fast read that differs from the byte-wise read (ROM_READ_CHECK builds)
+    void read_mismatch(uint32_t addr, int size, uint32_t fast, uint32_t expected);
+
 private:
     int create_map();
     int filesize(const char* filename);
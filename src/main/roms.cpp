@@ -7,6 +7,7 @@
 
 #include <iostream>
 #include <cstring>
+#include <boost/crc.hpp>
 #include "stdint.hpp"
 #include "roms.hpp"
 
@@ -27,64 +28,153 @@ Roms::~Roms(void)
 // Expanded example: (rom0.*(rom0.load))("epr-10380b.133", 0x00000, 0x10000, 0x1f6cadad, RomLoader::INTERLEAVE2);
 #define LOAD(rom, args) (rom.*(rom.load)) args
 
-bool Roms::load_revb_roms(bool fixed_rom)
+struct rom_t
+{
+    const char* filename;
+    int offset;
+    int length;
+    uint32_t crc;
+    uint8_t mode;
+};
+
+#define LOAD_TABLE(rom, table) \
+    for (uint32_t i = 0; i < sizeof(table) / sizeof(rom_t); i++) \
+        status += LOAD(rom, (table[i].filename, table[i].offset, table[i].length, table[i].crc, table[i].mode, VERBOSE))
+
+// Master CPU ROMs
+static const rom_t ROM0_ROMS[] =
+{
+    { "epr-10380b.133", 0x00000, 0x10000, 0x1f6cadad, RomLoader::INTERLEAVE2 },
+    { "epr-10382b.118", 0x00001, 0x10000, 0xc4c3fa1a, RomLoader::INTERLEAVE2 },
+    { "epr-10381b.132", 0x20000, 0x10000, 0xbe8c412b, RomLoader::INTERLEAVE2 },
+    { "epr-10383b.117", 0x20001, 0x10000, 0x10a2014a, RomLoader::INTERLEAVE2 },
+};
+
+// Slave CPU ROMs
+static const rom_t ROM1_ROMS[] =
+{
+    { "epr-10327a.76", 0x00000, 0x10000, 0xe28a5baf, RomLoader::INTERLEAVE2 },
+    { "epr-10329a.58", 0x00001, 0x10000, 0xda131c81, RomLoader::INTERLEAVE2 },
+    { "epr-10328a.75", 0x20000, 0x10000, 0xd5ec5e5d, RomLoader::INTERLEAVE2 },
+    { "epr-10330a.57", 0x20001, 0x10000, 0xba9ec82a, RomLoader::INTERLEAVE2 },
+};
+
+// Z80 Sound ROM
+static const rom_t Z80_ROMS[] =
+{
+    { "epr-10187.88", 0x0000, 0x08000, 0xa10abaa9, RomLoader::NORMAL },
+};
+
+// Sega PCM Chip Samples (the last ROM is replaced by load_pcm_rom)
+static const rom_t PCM_ROMS[] =
+{
+    { "opr-10193.66", 0x00000, 0x08000, 0xbcd10dde, RomLoader::NORMAL },
+    { "opr-10192.67", 0x10000, 0x08000, 0x770f1270, RomLoader::NORMAL },
+    { "opr-10191.68", 0x20000, 0x08000, 0x20a284ab, RomLoader::NORMAL },
+    { "opr-10190.69", 0x30000, 0x08000, 0x7cab70e2, RomLoader::NORMAL },
+    { "opr-10189.70", 0x40000, 0x08000, 0x01366b54, RomLoader::NORMAL },
+    { "opr-10188.71", 0x50000, 0x08000, 0xbad30ad9, RomLoader::NORMAL },
+};
+
+// Non-Interleaved Tile ROMs
+static const rom_t TILE_ROMS[] =
+{
+    { "opr-10268.99",  0x00000, 0x08000, 0x95344b04, RomLoader::NORMAL },
+    { "opr-10232.102", 0x08000, 0x08000, 0x776ba1eb, RomLoader::NORMAL },
+    { "opr-10267.100", 0x10000, 0x08000, 0xa85bb823, RomLoader::NORMAL },
+    { "opr-10231.103", 0x18000, 0x08000, 0x8908bcbf, RomLoader::NORMAL },
+    { "opr-10266.101", 0x20000, 0x08000, 0x9f6f1a74, RomLoader::NORMAL },
+    { "opr-10230.104", 0x28000, 0x08000, 0x686f5e50, RomLoader::NORMAL },
+};
+
+// Non-Interleaved Road ROMs (2 identical roms, 1 for each road)
+static const rom_t ROAD_ROMS[] =
+{
+    { "opr-10185.11", 0x000000, 0x08000, 0x22794426, RomLoader::NORMAL },
+    { "opr-10186.47", 0x008000, 0x08000, 0x22794426, RomLoader::NORMAL },
+};
+
+// Interleaved Sprite ROMs
+static const rom_t SPRITE_ROMS[] =
+{
+    { "mpr-10371.9",  0x000000, 0x20000, 0x7cc86208, RomLoader::INTERLEAVE4 },
+    { "mpr-10373.10", 0x000001, 0x20000, 0xb0d26ac9, RomLoader::INTERLEAVE4 },
+    { "mpr-10375.11", 0x000002, 0x20000, 0x59b60bd7, RomLoader::INTERLEAVE4 },
+    { "mpr-10377.12", 0x000003, 0x20000, 0x17a1b04a, RomLoader::INTERLEAVE4 },
+    { "mpr-10372.13", 0x080000, 0x20000, 0xb557078c, RomLoader::INTERLEAVE4 },
+    { "mpr-10374.14", 0x080001, 0x20000, 0x8051e517, RomLoader::INTERLEAVE4 },
+    { "mpr-10376.15", 0x080002, 0x20000, 0xf3b8f318, RomLoader::INTERLEAVE4 },
+    { "mpr-10378.16", 0x080003, 0x20000, 0xa1062984, RomLoader::INTERLEAVE4 },
+};
+
+static void add_to_key(boost::crc_32_type& key, const rom_t* table, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const int32_t fields[] = { table[i].offset, table[i].length, (int32_t) table[i].crc, table[i].mode };
+        key.process_bytes(fields, sizeof(fields));
+    }
+}
+
+// Cached data is only valid for these exact ROMs
+uint32_t Roms::rom_key(bool fixed_rom)
+{
+    boost::crc_32_type key;
+    add_to_key(key, ROM0_ROMS,   sizeof(ROM0_ROMS)   / sizeof(rom_t));
+    add_to_key(key, ROM1_ROMS,   sizeof(ROM1_ROMS)   / sizeof(rom_t));
+    add_to_key(key, TILE_ROMS,   sizeof(TILE_ROMS)   / sizeof(rom_t));
+    add_to_key(key, ROAD_ROMS,   sizeof(ROAD_ROMS)   / sizeof(rom_t));
+    add_to_key(key, SPRITE_ROMS, sizeof(SPRITE_ROMS) / sizeof(rom_t));
+    add_to_key(key, Z80_ROMS,    sizeof(Z80_ROMS)    / sizeof(rom_t));
+    add_to_key(key, PCM_ROMS,    sizeof(PCM_ROMS)    / sizeof(rom_t));
+
+    const uint8_t fixed = fixed_rom ? 1 : 0;
+    key.process_bytes(&fixed, sizeof(fixed));
+    return key.checksum();
+}
+
+// video_roms:   Load the tile, road and sprite ROMs. Not required when the decoded data has been cached.
+// program_roms: Load the CPU, sound and sample ROMs. Not required when mapped from the shared asset store.
+bool Roms::load_revb_roms(bool fixed_rom, bool video_roms, bool program_roms)
 {
     // If incremented, a rom has failed to load.
     int status = 0;
 
-    // Load Master CPU ROMs
-    rom0.init(0x40000);
-    status += LOAD(rom0, ("epr-10380b.133", 0x00000, 0x10000, 0x1f6cadad, RomLoader::INTERLEAVE2, VERBOSE));
-    status += LOAD(rom0, ("epr-10382b.118", 0x00001, 0x10000, 0xc4c3fa1a, RomLoader::INTERLEAVE2, VERBOSE));
-    status += LOAD(rom0, ("epr-10381b.132", 0x20000, 0x10000, 0xbe8c412b, RomLoader::INTERLEAVE2, VERBOSE));
-    status += LOAD(rom0, ("epr-10383b.117", 0x20001, 0x10000, 0x10a2014a, RomLoader::INTERLEAVE2, VERBOSE));
-
-    // Load Slave CPU ROMs
-    rom1.init(0x40000);
-    status += LOAD(rom1, ("epr-10327a.76", 0x00000, 0x10000, 0xe28a5baf, RomLoader::INTERLEAVE2, VERBOSE));
-    status += LOAD(rom1, ("epr-10329a.58", 0x00001, 0x10000, 0xda131c81, RomLoader::INTERLEAVE2, VERBOSE));
-    status += LOAD(rom1, ("epr-10328a.75", 0x20000, 0x10000, 0xd5ec5e5d, RomLoader::INTERLEAVE2, VERBOSE));
-    status += LOAD(rom1, ("epr-10330a.57", 0x20001, 0x10000, 0xba9ec82a, RomLoader::INTERLEAVE2, VERBOSE));
-
-    // Load Non-Interleaved Tile ROMs
-    tiles.init(0x30000);
-    status += LOAD(tiles, ("opr-10268.99", 0x00000, 0x08000, 0x95344b04, RomLoader::NORMAL, VERBOSE));
-    status += LOAD(tiles, ("opr-10232.102", 0x08000, 0x08000, 0x776ba1eb, RomLoader::NORMAL, VERBOSE));
-    status += LOAD(tiles, ("opr-10267.100", 0x10000, 0x08000, 0xa85bb823, RomLoader::NORMAL, VERBOSE));
-    status += LOAD(tiles, ("opr-10231.103", 0x18000, 0x08000, 0x8908bcbf, RomLoader::NORMAL, VERBOSE));
-    status += LOAD(tiles, ("opr-10266.101", 0x20000, 0x08000, 0x9f6f1a74, RomLoader::NORMAL, VERBOSE));
-    status += LOAD(tiles, ("opr-10230.104", 0x28000, 0x08000, 0x686f5e50, RomLoader::NORMAL, VERBOSE));
-
-    // Load Non-Interleaved Road ROMs (2 identical roms, 1 for each road)
-    road.init(0x10000);
-    status += LOAD(road, ("opr-10185.11", 0x000000, 0x08000, 0x22794426, RomLoader::NORMAL, VERBOSE));
-    status += LOAD(road, ("opr-10186.47", 0x008000, 0x08000, 0x22794426, RomLoader::NORMAL, VERBOSE));
-
-    // Load Interleaved Sprite ROMs
-    sprites.init(0x100000);
-    status += LOAD(sprites, ("mpr-10371.9", 0x000000, 0x20000, 0x7cc86208, RomLoader::INTERLEAVE4, VERBOSE));
-    status += LOAD(sprites, ("mpr-10373.10", 0x000001, 0x20000, 0xb0d26ac9, RomLoader::INTERLEAVE4, VERBOSE));
-    status += LOAD(sprites, ("mpr-10375.11", 0x000002, 0x20000, 0x59b60bd7, RomLoader::INTERLEAVE4, VERBOSE));
-    status += LOAD(sprites, ("mpr-10377.12", 0x000003, 0x20000, 0x17a1b04a, RomLoader::INTERLEAVE4, VERBOSE));
-    status += LOAD(sprites, ("mpr-10372.13", 0x080000, 0x20000, 0xb557078c, RomLoader::INTERLEAVE4, VERBOSE));
-    status += LOAD(sprites, ("mpr-10374.14", 0x080001, 0x20000, 0x8051e517, RomLoader::INTERLEAVE4, VERBOSE));
-    status += LOAD(sprites, ("mpr-10376.15", 0x080002, 0x20000, 0xf3b8f318, RomLoader::INTERLEAVE4, VERBOSE));
-    status += LOAD(sprites, ("mpr-10378.16", 0x080003, 0x20000, 0xa1062984, RomLoader::INTERLEAVE4, VERBOSE));
-
-    // Load Z80 Sound ROM
-    // Note: This is a deliberate decision to double the Z80 ROM Space to accomodate extra FM based music
-    z80.init(0x10000);
-    status += LOAD(z80, ("epr-10187.88", 0x0000, 0x08000, 0xa10abaa9, RomLoader::NORMAL, VERBOSE));
-
-    // Load Sega PCM Chip Samples
-    pcm.init(0x60000);
-    status += LOAD(pcm, ("opr-10193.66", 0x00000, 0x08000, 0xbcd10dde, RomLoader::NORMAL, VERBOSE));
-    status += LOAD(pcm, ("opr-10192.67", 0x10000, 0x08000, 0x770f1270, RomLoader::NORMAL, VERBOSE));
-    status += LOAD(pcm, ("opr-10191.68", 0x20000, 0x08000, 0x20a284ab, RomLoader::NORMAL, VERBOSE));
-    status += LOAD(pcm, ("opr-10190.69", 0x30000, 0x08000, 0x7cab70e2, RomLoader::NORMAL, VERBOSE));
-    status += LOAD(pcm, ("opr-10189.70", 0x40000, 0x08000, 0x01366b54, RomLoader::NORMAL, VERBOSE));
-    status += LOAD(pcm, ("opr-10188.71", 0x50000, 0x08000, 0xbad30ad9, RomLoader::NORMAL, VERBOSE));
-    status += load_pcm_rom(fixed_rom);
+    if (program_roms)
+    {
+        // Load Master CPU ROMs
+        rom0.init(ROM0_LENGTH);
+        LOAD_TABLE(rom0, ROM0_ROMS);
+
+        // Load Slave CPU ROMs
+        rom1.init(ROM1_LENGTH);
+        LOAD_TABLE(rom1, ROM1_ROMS);
+    }
+
+    if (video_roms)
+    {
+        tiles.init(0x30000);
+        LOAD_TABLE(tiles, TILE_ROMS);
+
+        road.init(0x10000);
+        LOAD_TABLE(road, ROAD_ROMS);
+
+        sprites.init(0x100000);
+        LOAD_TABLE(sprites, SPRITE_ROMS);
+    }
+
+    if (program_roms)
+    {
+        // Load Z80 Sound ROM
+        // Note: This is a deliberate decision to double the Z80 ROM Space to accomodate extra FM based music
+        z80.init(Z80_LENGTH);
+        LOAD_TABLE(z80, Z80_ROMS);
+
+        // Load Sega PCM Chip Samples
+        pcm.init(PCM_LENGTH);
+        LOAD_TABLE(pcm, PCM_ROMS);
+        status += load_pcm_rom(fixed_rom);
+    }
 
     // If status has been incremented, a rom has failed to load.
     return status == 0;
@@ -117,6 +207,17 @@ bool Roms::load_japanese_roms()
     return jap_rom_status == 0;
 }
 
+// Release the Japanese ROMs. They will be loaded again if required.
+void Roms::unload_japanese_roms()
+{
+    if (jap_rom_status == -1)
+        return;
+
+    j_rom0.unload();
+    j_rom1.unload();
+    jap_rom_status = -1;
+}
+
 int Roms::load_pcm_rom(bool fixed_rom)
 {
     int status = 0;
@@ -142,6 +243,7 @@ bool Roms::load_ym_data(const char* filename)
     {
         if (data.length < 0x8000)
         {
+            z80.make_private(); // Copy on write, if shared
             memcpy(z80.rom + 0x8000, data.rom, data.length);
             data.unload();
             return true;
@@ -31,11 +31,21 @@ public:
 
     Roms();
     ~Roms();
-    bool load_revb_roms(bool);
+    // Sizes of the program, sound and sample ROMs
+    const static uint32_t ROM0_LENGTH = 0x40000;
+    const static uint32_t ROM1_LENGTH = 0x40000;
+    const static uint32_t Z80_LENGTH  = 0x10000;
+    const static uint32_t PCM_LENGTH  = 0x60000;
+
+    bool load_revb_roms(bool fixed_rom, bool video_roms = true, bool program_roms = true);
     bool load_japanese_roms();
+    void unload_japanese_roms();
     int load_pcm_rom(bool);
     bool load_ym_data(const char* filename);
 
+    // Identifies the ROM set (for caching the decoded data)
+    uint32_t rom_key(bool fixed_rom);
+
 private:
     int jap_rom_status;
     const static bool VERBOSE = true;
@@ -0,0 +1,53 @@
+/***************************************************************************
+    Save States.
+
+    A snapshot of a set of memory regions, which can be restored later.
+
+    Each part of the engine adds the regions that hold its state: the
+    engine objects themselves, plus video, road and sprite RAM, the palette
+    and the sound queue. Saving and loading is then a copy of each region
+    to or from a single buffer.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include <cstring>
+#include "savestate.hpp"
+
+SaveState::SaveState()
+{
+}
+
+SaveState::~SaveState()
+{
+}
+
+void SaveState::add(void* data, size_t size)
+{
+    region_t region;
+    region.data = (uint8_t*) data;
+    region.size = size;
+    regions.push_back(region);
+    buffer.resize(buffer.size() + size);
+}
+
+void SaveState::save()
+{
+    uint8_t* dst = buffer.data();
+    for (size_t i = 0; i < regions.size(); i++)
+    {
+        memcpy(dst, regions[i].data, regions[i].size);
+        dst += regions[i].size;
+    }
+}
+
+void SaveState::load()
+{
+    const uint8_t* src = buffer.data();
+    for (size_t i = 0; i < regions.size(); i++)
+    {
+        memcpy(regions[i].data, src, regions[i].size);
+        src += regions[i].size;
+    }
+}
@@ -0,0 +1,51 @@
+/***************************************************************************
+    Save States.
+
+    A snapshot of a set of memory regions, which can be restored later.
+
+    Each part of the engine adds the regions that hold its state: the
+    engine objects themselves, plus video, road and sprite RAM, the palette
+    and the sound queue. Saving and loading is then a copy of each region
+    to or from a single buffer.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "stdint.hpp"
+
+class SaveState
+{
+public:
+    SaveState();
+    ~SaveState();
+
+    // Add a region of memory to the state
+    void add(void* data, size_t size);
+
+    // Add an object to the state. The object must be plain data, with no members that own memory.
+    template <class T> void add(T& object) { add(&object, sizeof(T)); }
+
+    // Take a snapshot of every region
+    void save();
+
+    // Restore every region from the last snapshot
+    void load();
+
+    // Total size of the state in bytes
+    size_t size() const { return buffer.size(); }
+
+private:
+    struct region_t
+    {
+        uint8_t* data;
+        size_t size;
+    };
+
+    std::vector<region_t> regions;
+    std::vector<uint8_t> buffer;
+};
@@ -14,6 +14,8 @@
     Copyright (c) 1998-2008 Atari800 development team
 ***************************************************************************/
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <cstring>
 #include <SDL.h>
@@ -21,6 +23,7 @@
 #include "sdl2/audio.hpp"
 #include "frontend/config.hpp" // fps
 #include "engine/audio/osoundint.hpp"
+#include "realtime.hpp"
 
 #ifdef COMPILE_SOUND_CODE
 
@@ -36,14 +39,29 @@ static int dsp_read_pos;
 static int callbacktick;     // tick at which callback occured
 static int bytes_per_sample; // Number of bytes per sample entry (usually 4 bytes if stereo and 16-bit sound)
 
+// Callback telemetry. Written by the callback, read by Audio::tick with the audio device locked.
+static Uint64 callback_last;    // Performance counter at last callback
+static double callback_period;  // Expected interval between callbacks (performance counter units)
+static double jitter_sum;       // Sum of deviation from expected interval
+static double jitter_max;       // Largest deviation from expected interval
+static int    jitter_count;     // Number of intervals measured
+static int    underruns;        // Callbacks that ran out of audio
+
 // SDL Audio Callback Function
 extern void fill_audio(void *udata, Uint8 *stream, int len);
 
+// Real-time settings are applied to the callback thread on its first call
+static bool   callback_setup;
+
 // ----------------------------------------------------------------------------
 
 Audio::Audio()
 {
 	sound_enabled = false;
+    fast_forward    = false;
+    stats_frames    = 0;
+    stats_underruns = 0;
+    stable_secs     = 0;
 }
 
 Audio::~Audio()
@@ -95,7 +113,8 @@ void Audio::start_audio()
         desired.freq     = config.sound.rate;
         desired.format   = AUDIO_S16SYS;
         desired.channels = CHANNELS;
-        desired.samples  = SAMPLES;
+        period           = config.sound.period;
+        desired.samples  = period;
         desired.callback = fill_audio;
         desired.userdata = NULL;
 	
@@ -119,29 +138,41 @@ void Audio::start_audio()
         // Start Audio
         sound_enabled = true;
 
+        // Adaptive mode reduces the delay from the configured value, and can increase it up to double
+        delay     = config.sound.delay;
+        delay_min = 0;
+        delay_max = config.sound.adaptive ? delay * 2 : delay;
+        stable_secs = 0;
+
         // how many fragments in the dsp buffer
-        const int DSP_BUFFER_FRAGS = 5;
-        int specified_delay_samps = (config.sound.rate * SND_DELAY) / 1000;
-        int dsp_buffer_samps = SAMPLES * DSP_BUFFER_FRAGS + specified_delay_samps;
+        int max_delay_samps  = (config.sound.rate * delay_max) / 1000;
+        int dsp_buffer_samps = period * config.sound.buffer + max_delay_samps;
         dsp_buffer_bytes = CHANNELS * dsp_buffer_samps * (BITS / 8);
         dsp_buffer = new uint8_t[dsp_buffer_bytes];
 
         // Create Buffer For Mixing
         uint16_t buffer_size = (config.sound.rate / config.fps) * CHANNELS;
-        mix_buffer = new uint16_t[buffer_size];
+        mix_buffer = new int16_t[buffer_size];
+        wav_stream_buffer = new int16_t[buffer_size];
+
+        // Mixer levels. Sound chip levels are set per chip in OSoundInt.
+        mixer.set_gain(Mixer::WAV,    config.sound.vol_wav);
+        mixer.set_gain(Mixer::MASTER, config.sound.vol_master);
 
         clear_buffers();
         clear_wav();
+        callback_setup = false;
 
-        SDL_PauseAudioDevice(dev,0);
+        // Stay paused if restarted while fast-forwarding
+        SDL_PauseAudioDevice(dev, fast_forward ? 1 : 0);
     }
 }
 
 void Audio::clear_buffers()
 {
     dsp_read_pos  = 0;
-    int specified_delay_samps = (config.sound.rate * SND_DELAY) / 1000;
-    dsp_write_pos = (specified_delay_samps+SAMPLES) * bytes_per_sample;
+    int specified_delay_samps = (config.sound.rate * delay) / 1000;
+    dsp_write_pos = (specified_delay_samps+period) * bytes_per_sample;
     avg_gap = 0.0;
     gap_est = 0;
 
@@ -153,6 +184,15 @@ void Audio::clear_buffers()
         mix_buffer[i] = 0;
 
     callbacktick = 0;
+
+    callback_last   = 0;
+    callback_period = ((double) period * SDL_GetPerformanceFrequency()) / config.sound.rate;
+    jitter_sum      = 0;
+    jitter_max      = 0;
+    jitter_count    = 0;
+    underruns       = 0;
+    stats_frames    = 0;
+    stats_underruns = 0;
 }
 
 void Audio::stop_audio()
@@ -163,12 +203,26 @@ void Audio::stop_audio()
 
         SDL_PauseAudioDevice(dev,1);
         SDL_CloseAudioDevice(dev);
+        wavstream.close();
 
         delete[] dsp_buffer;
         delete[] mix_buffer;
+        delete[] wav_stream_buffer;
     }
 }
 
+void Audio::set_fast_forward(bool on)
+{
+    if (on == fast_forward)
+        return;
+
+    fast_forward = on;
+
+    // Restart with a clear buffer, so the audio resumes with the normal latency
+    if (on) pause_audio();
+    else    resume_audio();
+}
+
 void Audio::pause_audio()
 {
     if (sound_enabled)
@@ -199,27 +253,28 @@ void Audio::tick()
     osoundint.pcm->stream_update();
     osoundint.ym->stream_update();
 
+    // Fast-forwarding: the chips are kept in step, but nothing is output
+    if (fast_forward) return;
+
     // Get the audio buffers we've just output
     int16_t *pcm_buffer = osoundint.pcm->get_buffer();
     int16_t *ym_buffer  = osoundint.ym->get_buffer();
-    int16_t *wav_buffer = wavfile.data;
+    int16_t *wav_buffer = wavfile.loaded ? wavfile.data : NULL;
 
     int samples_written = osoundint.pcm->buffer_size;
 
-    // And mix them into the mix_buffer
-    for (int i = 0; i < samples_written; i++)
+    // And mix them into the mix_buffer, looping the wav file
+    mixer.set_gain(Mixer::YM,  osoundint.ym->get_volume());
+    mixer.set_gain(Mixer::PCM, osoundint.pcm->get_volume());
+    if (wavstream.is_open())
     {
-        int32_t mix_data = wav_buffer[wavfile.pos] + pcm_buffer[i] + ym_buffer[i];
-
-        // Clip mix data
-        if (mix_data > INT16_MAX) mix_data = INT16_MAX;
-        else if (mix_data < INT16_MIN) mix_data = INT16_MIN;
-
-        mix_buffer[i] = mix_data;
-
-        // Loop wav files
-        if (++wavfile.pos >= wavfile.length)
-            wavfile.pos = 0;
+        uint32_t stream_pos = 0;
+        wavstream.read(wav_stream_buffer, samples_written);
+        mixer.mix(mix_buffer, ym_buffer, pcm_buffer, samples_written, wav_stream_buffer, stream_pos, samples_written);
+    }
+    else
+    {
+        mixer.mix(mix_buffer, ym_buffer, pcm_buffer, samples_written, wav_buffer, wavfile.pos, wavfile.length);
     }
 
     // Cast mix_buffer to a byte array, to align it with internal SDL format 
@@ -274,13 +329,76 @@ void Audio::tick()
         dsp_read_pos -= dsp_buffer_bytes;
     }
     SDL_UnlockAudio();
+
+    update_stats();
+}
+
+// Called every frame. Once per second, adapt the latency and report statistics.
+void Audio::update_stats()
+{
+    if (++stats_frames < config.fps)
+        return;
+
+    stats_frames = 0;
+
+    SDL_LockAudio();
+    int underruns_now = underruns - stats_underruns;
+    stats_underruns = underruns;
+    SDL_UnlockAudio();
+
+    if (config.sound.adaptive)
+    {
+        // Underrun: back off, and don't go this low again
+        if (underruns_now > 0)
+        {
+            delay_min   = std::min(delay + ADAPT_STEP, delay_max);
+            delay       = std::min(delay + ADAPT_STEP * 4, delay_max);
+            stable_secs = 0;
+        }
+        // Stable: try a little less latency
+        else if (++stable_secs >= ADAPT_STABLE && delay - ADAPT_STEP >= delay_min)
+        {
+            delay      -= ADAPT_STEP;
+            stable_secs = 0;
+        }
+    }
+
+    if (config.sound.stats)
+    {
+        audio_stats_t stats;
+        get_stats(stats);
+        std::cout << "Audio: latency " << stats.latency_ms << " ms, target delay " << stats.delay_ms
+                  << " ms, jitter " << stats.jitter_ms << " ms (max " << stats.jitter_max
+                  << " ms), underruns " << stats.underruns << std::endl;
+    }
+}
+
+void Audio::get_stats(audio_stats_t& stats)
+{
+    if (!sound_enabled)
+    {
+        stats = audio_stats_t();
+        return;
+    }
+
+    const double bytes_per_ms  = bytes_per_sample * (config.sound.rate / 1000.0);
+    const double counter_to_ms = 1000.0 / SDL_GetPerformanceFrequency();
+
+    SDL_LockAudio();
+    stats.jitter_ms  = jitter_count ? (jitter_sum / jitter_count) * counter_to_ms : 0;
+    stats.jitter_max = jitter_max * counter_to_ms;
+    stats.underruns  = underruns;
+    SDL_UnlockAudio();
+
+    stats.latency_ms = (avg_gap / bytes_per_ms) + ((period * 1000.0) / config.sound.rate);
+    stats.delay_ms   = delay;
 }
 
 // Adjust the speed of the emulator, based on audio streaming performance.
 // This ensures that we avoid pops and crackles (in theory). 
 double Audio::adjust_speed()
 {
-    if (!sound_enabled)
+    if (!sound_enabled || fast_forward)
         return 1.0;
 
     double alpha = 2.0 / (1.0+40.0);
@@ -298,8 +416,8 @@ double Audio::adjust_speed()
         avg_gap = avg_gap + alpha * (gap_est - avg_gap);
     }
 
-    gap_too_small = (SND_DELAY * config.sound.rate * bytes_per_sample)/1000;
-    gap_too_large = ((SND_DELAY + SND_SPREAD) * config.sound.rate * bytes_per_sample)/1000;
+    gap_too_small = (delay * config.sound.rate * bytes_per_sample)/1000;
+    gap_too_large = ((delay + SND_SPREAD) * config.sound.rate * bytes_per_sample)/1000;
     
     if (avg_gap < gap_too_small) 
     {
@@ -323,6 +441,12 @@ void Audio::load_wav(const char* filename)
     {
         clear_wav();
 
+        // Stream the file from disk. This returns immediately, as conversion happens on a background thread.
+        if (wavstream.open(filename, config.sound.rate, CHANNELS))
+            return;
+
+        // Otherwise, fall back to loading and converting the entire file (e.g. compressed formats)
+
         // Load Wav File
         SDL_AudioSpec wave;
     
@@ -381,6 +505,8 @@ void Audio::load_wav(const char* filename)
 
 void Audio::clear_wav()
 {
+    wavstream.close();
+
     if (wavfile.loaded)
     {
         if (wavfile.loaded == 1)
@@ -410,9 +536,30 @@ void fill_audio(void *udata, Uint8 *stream, int len)
 #define MAX_SAMPLE_SIZE 4
     static char last_bytes[MAX_SAMPLE_SIZE];
 
+    if (!callback_setup)
+    {
+        callback_setup = true;
+        // When audio is restarted, the callback thread is created by the main thread and inherits its settings
+        realtime::reset_thread("audio");
+        realtime::apply_thread("audio", config.realtime.audio_core, config.realtime.policy, config.realtime.audio_priority);
+    }
+
+    // Measure how far the interval between callbacks strays from the device period
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (callback_last != 0)
+    {
+        double deviation = std::abs((double) (now - callback_last) - callback_period);
+        jitter_sum += deviation;
+        if (deviation > jitter_max)
+            jitter_max = deviation;
+        jitter_count++;
+    }
+    callback_last = now;
+
     gap = dsp_write_pos - dsp_read_pos;
     if (gap < len) 
     {
+        underruns++;
         underflow_amount = len - gap;
         len = gap;
     }
@@ -17,8 +17,20 @@
 #pragma once
 
 #include "globals.hpp"
+#include "hwaudio/mixer.hpp"
+#include "sdl2/wavstream.hpp"
 #include <SDL.h>
 
+// Audio latency telemetry
+struct audio_stats_t
+{
+    double latency_ms;  // Measured output latency: buffered audio plus the device period
+    double jitter_ms;   // Mean deviation of the callback interval from the device period
+    double jitter_max;  // Worst deviation of the callback interval from the device period
+    int delay_ms;       // Current target delay (changes in adaptive mode)
+    int underruns;      // Total number of callbacks that ran out of audio
+};
+
 #ifdef COMPILE_SOUND_CODE
 
 struct wav_t {
@@ -41,10 +53,17 @@ public:
     double adjust_speed();
     void load_wav(const char* filename);
     void clear_wav();
+    void get_stats(audio_stats_t& stats);
+
+    // Fast-forward: mute the output, while the sound chips still follow the sound program
+    void set_fast_forward(bool on);
 
 private:
 	// Enable/Disable Sound
 	bool sound_enabled;
+
+    // Fast-forwarding: output is paused
+    bool fast_forward;
 	
     // Stereo. Could be changed, requires some recoding.
     static const uint32_t CHANNELS = 2;
@@ -52,21 +71,47 @@ private:
     // 16-Bit Audio Output. Could be changed, requires some recoding.
     static const uint32_t BITS = 16;
 
+    // allowed "spread" between too many and too few samples in the buffer (ms)
+    const static int SND_SPREAD = 7;
+
+    // Adaptive latency: step (ms) to reduce the delay by, after this many seconds without an underrun
+    const static int ADAPT_STEP   = 1;
+    const static int ADAPT_STABLE = 3;
+
+    // Samples per device callback (from config.xml).
     // Low value  = Responsiveness, chance of drop out.
     // High value = Laggy, less chance of drop out.
-    static const uint32_t SAMPLES  = 1024;
+    uint32_t period;
 
-    // Latency (in ms) and thus target buffer size
-    const static int SND_DELAY = 20;
+    // Latency (in ms) and thus target buffer size. Adjusted at run-time in adaptive mode.
+    int delay;
 
-    // allowed "spread" between too many and too few samples in the buffer (ms)
-    const static int SND_SPREAD = 7;
+    // Adaptive mode: delay will not be reduced below this, as it caused underruns
+    int delay_min;
+
+    // Upper limit of delay, which the buffer is sized for
+    int delay_max;
+
+    // Frames and underruns counted since the last statistics update
+    int stats_frames;
+    int stats_underruns;
+    int stable_secs;
     
     // Buffer used to mix PCM and YM channels together
-    uint16_t* mix_buffer;
+    int16_t* mix_buffer;
+
+    // Mixes the sound chips and WAV file with per source gain
+    Mixer mixer;
 
+    // WAV file loaded in full (used when the format can't be streamed)
     wav_t wavfile;
 
+    // WAV file streamed from disk
+    WavStream wavstream;
+
+    // Frame of samples read from the streamed WAV file
+    int16_t* wav_stream_buffer;
+
     // Estimated gap
     int gap_est;
 
@@ -74,6 +119,7 @@ private:
     double avg_gap;
 
     void clear_buffers();
+    void update_stats();
     void pause_audio();
     void resume_audio();
 
@@ -97,5 +143,7 @@ public:
     double adjust_speed() { return 1.0; }
     void load_wav(const char* filename);
     void clear_wav() {}
+    void get_stats(audio_stats_t& stats) { stats = audio_stats_t(); }
+    void set_fast_forward(bool on) {}
 };
 #endif
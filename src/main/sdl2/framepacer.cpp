@@ -0,0 +1,181 @@
+/***************************************************************************
+    High Resolution Frame Pacer.
+
+    Paces frames when V-Sync is not available, using the high resolution
+    performance counter rather than millisecond ticks.
+
+    Each frame has an absolute deadline, so rounding errors don't
+    accumulate. The pacer sleeps until shortly before the deadline, then
+    spins for the remainder, which avoids scheduler overshoot.
+
+    With V-Sync, the pacer can instead delay the start of each frame, so
+    that input is read as late as possible before the next buffer swap.
+
+    Will need to be replaced if SDL library is replaced.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include <chrono>
+#include <thread>
+#include <SDL.h>
+
+#include "sdl2/framepacer.hpp"
+
+FramePacer::FramePacer()
+{
+    counter_per_ms = 1;
+    spin           = 0;
+    margin         = 0;
+    deadline       = 0;
+    last           = 0;
+    skips          = 0;
+    elapsed_last   = 0;
+    work_start     = 0;
+    work_predict   = 0;
+    reset_stats();
+}
+
+FramePacer::~FramePacer()
+{
+}
+
+void FramePacer::init(int spin_us, int margin_us)
+{
+    counter_per_ms = SDL_GetPerformanceFrequency() / 1000.0;
+    spin           = (uint64_t) (spin_us   * (counter_per_ms / 1000.0));
+    margin         = (uint64_t) (margin_us * (counter_per_ms / 1000.0));
+    deadline       = 0;
+    last           = 0;
+    skips          = 0;
+    elapsed_last   = 0;
+    work_start     = 0;
+    work_predict   = 0;
+    reset_stats();
+}
+
+// Sleep until just before the time, then spin for the remainder. Sleeping is coarse and may overshoot.
+void FramePacer::sleep_until(uint64_t time)
+{
+    const uint64_t now = SDL_GetPerformanceCounter();
+
+    if (time > now + spin)
+    {
+        const double sleep_ms = (time - spin - now) / counter_per_ms;
+        std::this_thread::sleep_for(std::chrono::microseconds((int64_t) (sleep_ms * 1000.0)));
+    }
+
+    while (SDL_GetPerformanceCounter() < time)
+        ;
+}
+
+void FramePacer::wait(double period_ms)
+{
+    const uint64_t now = SDL_GetPerformanceCounter();
+
+    // First frame, or more than a frame behind this frame's deadline (e.g. after loading):
+    // restart timing from now. Otherwise a late frame doesn't wait, so the time is made up.
+    const uint64_t period = (uint64_t) (period_ms * counter_per_ms);
+    if (deadline == 0 || now > deadline + (2 * period))
+        deadline = now;
+    else
+    {
+        deadline += period;
+        sleep_until(deadline);
+    }
+    work_start = SDL_GetPerformanceCounter();
+
+    // Statistics
+    const uint64_t jitter = work_start - deadline;
+    jitter_sum += jitter;
+    if (jitter > jitter_max)     jitter_max = jitter;
+    if (jitter > counter_per_ms) late++;
+    waits++;
+}
+
+void FramePacer::latch(double period_ms)
+{
+    // Time the next swap is due, less the time needed to prepare the frame
+    if (last)
+    {
+        const double start = last + (period_ms * counter_per_ms) - (work_predict + margin);
+        if (start > 0)
+            sleep_until((uint64_t) start);
+    }
+
+    work_start = SDL_GetPerformanceCounter();
+}
+
+void FramePacer::work_done()
+{
+    if (work_start == 0)
+        return;
+
+    // Follow peaks immediately, then decay by around 1% each frame
+    const double work = (double) (SDL_GetPerformanceCounter() - work_start);
+    work_predict *= 0.99;
+    if (work > work_predict)
+        work_predict = work;
+}
+
+void FramePacer::skipped(double period_ms)
+{
+    skips++;
+    if (last)
+        sleep_until(last + (uint64_t) (skips * period_ms * counter_per_ms));
+}
+
+void FramePacer::presented(uint32_t input_ticks)
+{
+    const uint64_t now = SDL_GetPerformanceCounter();
+    skips = 0;
+
+    if (last)
+    {
+        const uint64_t frame = now - last;
+        frame_sum += frame;
+        if (frame > frame_max) frame_max = frame;
+        frames++;
+    }
+    last = now;
+
+    // Event timestamps are in milliseconds
+    if (input_ticks)
+    {
+        const uint32_t latency = SDL_GetTicks() - input_ticks;
+        input_sum += latency;
+        if (latency > input_max) input_max = latency;
+        inputs++;
+    }
+}
+
+double FramePacer::elapsed()
+{
+    const uint64_t now  = SDL_GetPerformanceCounter();
+    const uint64_t prev = elapsed_last;
+    elapsed_last = now;
+
+    return prev ? (now - prev) / counter_per_ms : 0;
+}
+
+void FramePacer::get_stats(pacer_stats_t& stats)
+{
+    stats.frame_ms   = frames ? (frame_sum  / (double) frames) / counter_per_ms : 0;
+    stats.frame_max  = frame_max / counter_per_ms;
+    stats.jitter_ms  = waits  ? (jitter_sum / (double) waits)  / counter_per_ms : 0;
+    stats.jitter_max = jitter_max / counter_per_ms;
+    stats.late       = late;
+    stats.input_ms   = inputs ? input_sum / (double) inputs : 0;
+    stats.input_max  = input_max;
+    stats.inputs     = inputs;
+}
+
+void FramePacer::reset_stats()
+{
+    frame_sum  = frame_max  = 0;
+    jitter_sum = jitter_max = 0;
+    frames     = waits = late = 0;
+    input_sum  = input_max  = 0;
+    inputs     = 0;
+}
@@ -0,0 +1,106 @@
+/***************************************************************************
+    High Resolution Frame Pacer.
+
+    Paces frames when V-Sync is not available, using the high resolution
+    performance counter rather than millisecond ticks.
+
+    Each frame has an absolute deadline, so rounding errors don't
+    accumulate. The pacer sleeps until shortly before the deadline, then
+    spins for the remainder, which avoids scheduler overshoot.
+
+    With V-Sync, the pacer can instead delay the start of each frame, so
+    that input is read as late as possible before the next buffer swap.
+
+    Will need to be replaced if SDL library is replaced.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#pragma once
+
+#include "stdint.hpp"
+
+struct pacer_stats_t
+{
+    double frame_ms;        // Average time between frames
+    double frame_max;       // Longest time between frames
+    double jitter_ms;       // Average difference between the deadline and the actual end of a frame
+    double jitter_max;      // Largest difference
+    int late;               // Frames that ended over 1 ms after their deadline
+    double input_ms;        // Average time from an input event to the frame that reflects it being presented
+    double input_max;       // Longest time
+    int inputs;             // Frames with input measured
+};
+
+class FramePacer
+{
+public:
+    FramePacer();
+    ~FramePacer();
+
+    // spin_us:   Time before each deadline to spin rather than sleep (microseconds)
+    // margin_us: Time to leave spare before each buffer swap, when latching input late (microseconds)
+    void init(int spin_us, int margin_us);
+
+    // Wait until the end of the current frame. period_ms: Length of this frame.
+    void wait(double period_ms);
+
+    // V-Sync: Wait until the latest time the next frame can start and still be ready for the next swap
+    void latch(double period_ms);
+
+    // Game logic and composition for the frame are complete
+    void work_done();
+
+    // V-Sync: The frame was skipped rather than presented, so there's no buffer swap to wait for.
+    // If running ahead, wait until the frame would have been presented.
+    void skipped(double period_ms);
+
+    // The frame has been presented.
+    // input_ticks: SDL_GetTicks() timestamp of the oldest input the frame reflects (0 = None)
+    void presented(uint32_t input_ticks);
+
+    // Time since the previous call, for accumulating logic frames (ms). The first call returns 0.
+    double elapsed();
+
+    // Statistics since the last call to reset_stats
+    void get_stats(pacer_stats_t& stats);
+    void reset_stats();
+
+private:
+    // Performance counter ticks per ms
+    double counter_per_ms;
+
+    // Ticks to spin before a deadline
+    uint64_t spin;
+
+    // Ticks to leave spare before a buffer swap
+    uint64_t margin;
+
+    // End of the current frame
+    uint64_t deadline;
+
+    // Time the last frame was presented
+    uint64_t last;
+
+    // Frames skipped since the last was presented
+    int skips;
+
+    // Time of the previous call to elapsed
+    uint64_t elapsed_last;
+
+    // Start of work on the current frame
+    uint64_t work_start;
+
+    // Predicted time to run the logic and compose a frame. Follows peaks, then decays.
+    double work_predict;
+
+    // Statistics
+    uint64_t frame_sum, frame_max;
+    uint64_t jitter_sum, jitter_max;
+    int frames, waits, late;
+    uint32_t input_sum, input_max;
+    int inputs;
+
+    void sleep_until(uint64_t time);
+};
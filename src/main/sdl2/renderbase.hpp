@@ -18,12 +18,18 @@ public:
     virtual void disable()                    = 0;
     virtual bool start_frame()                = 0;
     virtual bool finalize_frame()             = 0;
-    virtual void draw_frame(uint16_t* pixels) = 0;
+    virtual void draw_frame(uint16_t* pixels, const uint32_t* palette) = 0;
     void convert_palette(uint32_t adr, uint32_t r1, uint32_t g1, uint32_t b1);
+    uint32_t* get_palette() { return rgb; }
     void set_shadow_intensity(float f);
     virtual bool supports_window() { return true; }
     virtual bool supports_vsync() { return false; }
 
+    // Frames can be drawn from a thread other than the one that set the video mode
+    virtual bool supports_render_thread() { return false; }
+    // Attach (or detach) the rendering context to the calling thread
+    virtual void make_current(bool /*current*/) {}
+
 protected:
 	SDL_Surface *surface;
 
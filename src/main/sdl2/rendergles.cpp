@@ -482,13 +482,13 @@ bool Render::finalize_frame()
     return true;
 }
 
-void Render::draw_frame(uint16_t* pixels)
+void Render::draw_frame(uint16_t* pixels, const uint32_t* palette)
 {
     uint32_t* spix = screen_pixels;
 
-    // Lookup real RGB value from rgb array for backbuffer
+    // Lookup real RGB value from palette for backbuffer
     for (int i = 0; i < (src_width * src_height); i++)
-        *(spix++) = rgb[*(pixels++)];
+        *(spix++) = palette[*(pixels++)];
 
     glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0,	       // target, LOD, xoff, yoff
             src_width, src_height,                     // texture width, texture height
@@ -507,3 +507,8 @@ bool Render::supports_vsync()
     return SDL_GL_SetSwapInterval(1) == 0;
 }
 
+void Render::make_current(bool current)
+{
+    SDL_GL_MakeCurrent(window, current ? glcontext : NULL);
+}
+
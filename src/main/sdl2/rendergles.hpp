@@ -44,9 +44,11 @@ public:
     void disable();
     bool start_frame();
     bool finalize_frame();
-    void draw_frame(uint16_t* pixels);
+    void draw_frame(uint16_t* pixels, const uint32_t* palette);
     bool supports_window() { return false; }
 	bool supports_vsync();
+	bool supports_render_thread() { return true; }
+	void make_current(bool current);
 
 
 private:
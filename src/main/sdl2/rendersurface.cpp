@@ -201,11 +201,11 @@ bool Render::finalize_frame()
     return true;
 }
 
-void Render::draw_frame(uint16_t* pixels)
+void Render::draw_frame(uint16_t* pixels, const uint32_t* palette)
 {
     uint32_t* spix = screen_pixels;
 
-    // Lookup real RGB value from rgb array for backbuffer
+    // Lookup real RGB value from palette for backbuffer
     for (int i = 0; i < (src_width * src_height); i++)
-        *(spix++) = rgb[*(pixels++)];
+        *(spix++) = palette[*(pixels++)];
 }
\ No newline at end of file
@@ -26,7 +26,7 @@ public:
     void disable();
     bool start_frame();
     bool finalize_frame();
-    void draw_frame(uint16_t* pixels);
+    void draw_frame(uint16_t* pixels, const uint32_t* palette);
 
 private:
     // SDL2 window
@@ -0,0 +1,247 @@
+/***************************************************************************
+    Streaming WAV Playback.
+
+    Plays a looping WAV file without loading it up front. The file is
+    memory mapped, and a background thread converts it to the output
+    format and sample rate in small chunks, using an SDL_AudioStream.
+
+    Converted audio is placed in a fixed size ring buffer, so memory use
+    does not depend on the length of the track.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include <cstring>
+#include <iostream>
+#include "sdl2/wavstream.hpp"
+#include "realtime.hpp"
+
+// WAV format tags
+static const uint16_t WAVE_PCM        = 0x0001;
+static const uint16_t WAVE_FLOAT      = 0x0003;
+static const uint16_t WAVE_EXTENSIBLE = 0xFFFE;
+
+static inline uint16_t read16_le(const uint8_t* p) { return p[0] | (p[1] << 8); }
+static inline uint32_t read32_le(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24); }
+
+WavStream::WavStream()
+{
+    src_data   = NULL;
+    src_length = 0;
+    src_pos    = 0;
+    stream     = NULL;
+    ring       = NULL;
+    ring_size  = 0;
+    read_pos   = 0;
+    write_pos  = 0;
+    running    = false;
+}
+
+WavStream::~WavStream()
+{
+    close();
+}
+
+bool WavStream::open(const char* filename, int rate, int channels)
+{
+    close();
+
+    if (!file.open(filename))
+        return false;
+
+    SDL_AudioFormat src_format;
+    int src_channels, src_freq;
+
+    if (!parse_header(src_format, src_channels, src_freq))
+    {
+        file.close();
+        return false;
+    }
+
+    stream = SDL_NewAudioStream(src_format, src_channels, src_freq, AUDIO_S16SYS, channels, rate);
+    if (stream == NULL)
+    {
+        file.close();
+        return false;
+    }
+
+    // At least half a second of converted audio. Power of 2, so positions can wrap.
+    ring_size = 1;
+    while (ring_size < (uint32_t) ((rate / 2) * channels))
+        ring_size <<= 1;
+    ring      = new int16_t[ring_size];
+    read_pos  = 0;
+    write_pos = 0;
+    src_pos   = 0;
+
+    running = true;
+    worker  = std::thread(&WavStream::produce, this);
+    return true;
+}
+
+void WavStream::close()
+{
+    if (running)
+    {
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex);
+            running = false;
+        }
+        wake.notify_one();
+    }
+
+    if (worker.joinable())
+        worker.join();
+
+    if (stream != NULL)
+    {
+        SDL_FreeAudioStream(stream);
+        stream = NULL;
+    }
+
+    delete[] ring;
+    ring       = NULL;
+    src_data   = NULL;
+    src_length = 0;
+    file.close();
+}
+
+// Locate the format and data chunks of the RIFF file.
+// Only uncompressed formats that SDL_AudioStream understands are supported.
+bool WavStream::parse_header(SDL_AudioFormat& format, int& channels, int& freq)
+{
+    const uint8_t* p   = file.data;
+    const size_t   len = file.length;
+
+    if (len < 12 || memcmp(p, "RIFF", 4) != 0 || memcmp(p + 8, "WAVE", 4) != 0)
+        return false;
+
+    bool have_fmt = false;
+    uint16_t tag  = 0;
+    uint16_t bits = 0;
+    size_t pos    = 12;
+
+    while (pos + 8 <= len)
+    {
+        const uint8_t* chunk = p + pos;
+        uint32_t size = read32_le(chunk + 4);
+        size_t body   = pos + 8;
+
+        if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16 && body + size <= len)
+        {
+            tag      = read16_le(p + body);
+            channels = read16_le(p + body + 2);
+            freq     = read32_le(p + body + 4);
+            bits     = read16_le(p + body + 14);
+
+            if (tag == WAVE_EXTENSIBLE && size >= 26)
+                tag = read16_le(p + body + 24); // First two bytes of sub format GUID
+            have_fmt = true;
+        }
+        else if (memcmp(chunk, "data", 4) == 0 && have_fmt)
+        {
+            src_data   = p + body;
+            src_length = (uint32_t) (size < len - body ? size : len - body); // Allow for truncated files
+            break;
+        }
+
+        pos = body + size + (size & 1); // Chunks are padded to an even size
+    }
+
+    if (src_data == NULL || channels < 1 || channels > 2 || freq <= 0)
+        return false;
+
+    if (tag == WAVE_PCM && bits == 8)        format = AUDIO_U8;
+    else if (tag == WAVE_PCM && bits == 16)  format = AUDIO_S16LSB;
+    else if (tag == WAVE_PCM && bits == 32)  format = AUDIO_S32LSB;
+    else if (tag == WAVE_FLOAT && bits == 32) format = AUDIO_F32LSB;
+    else
+        return false;
+
+    // Only convert whole sample frames
+    const uint32_t frame_bytes = channels * (bits / 8);
+    src_length -= src_length % frame_bytes;
+
+    return src_length != 0;
+}
+
+// Background thread: keep the ring buffer topped up with converted audio
+void WavStream::produce()
+{
+    realtime::reset_thread("music");
+
+    const uint32_t TEMP_SAMPLES = 2048;
+    int16_t temp[TEMP_SAMPLES];
+
+    while (running)
+    {
+        uint32_t space = ring_size - (write_pos - read_pos);
+
+        // Ring buffer full: wait for the audio code to consume some samples
+        if (space < TEMP_SAMPLES)
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex);
+            wake.wait_for(lock, std::chrono::milliseconds(10));
+            continue;
+        }
+
+        int got = SDL_AudioStreamGet(stream, temp, TEMP_SAMPLES * sizeof(int16_t));
+        if (got < 0)
+        {
+            fail("convert");
+            return;
+        }
+
+        if (got > 0)
+        {
+            uint32_t samples = got / sizeof(int16_t);
+            uint32_t wpos    = write_pos;
+
+            for (uint32_t i = 0; i < samples; i++)
+                ring[(wpos + i) & (ring_size - 1)] = temp[i] >> 1; // Halve volume of wav file
+
+            write_pos = wpos + samples;
+            continue;
+        }
+
+        // Feed the next chunk of the file, looping back to the start for a seamless repeat
+        uint32_t bytes = src_length - src_pos;
+        if (bytes > CHUNK_BYTES)
+            bytes = CHUNK_BYTES;
+
+        if (SDL_AudioStreamPut(stream, src_data + src_pos, bytes) != 0)
+        {
+            fail("read");
+            return;
+        }
+
+        src_pos += bytes;
+        if (src_pos >= src_length)
+            src_pos = 0;
+    }
+}
+
+// Stop streaming after an error. is_open() then returns false, so the audio code stops reading the stream.
+void WavStream::fail(const char* stage)
+{
+    std::cout << "Music stream: Unable to " << stage << " WAV data (" << SDL_GetError() << "). Music stopped." << std::endl;
+    running = false;
+}
+
+void WavStream::read(int16_t* dst, uint32_t samples)
+{
+    uint32_t rpos      = read_pos;
+    uint32_t available = write_pos - rpos;
+    uint32_t count     = samples < available ? samples : available;
+
+    for (uint32_t i = 0; i < count; i++)
+        dst[i] = ring[(rpos + i) & (ring_size - 1)];
+
+    // Not enough converted yet (e.g. just started): pad with silence
+    for (uint32_t i = count; i < samples; i++)
+        dst[i] = 0;
+
+    read_pos = rpos + count;
+    wake.notify_one();
+}
@@ -0,0 +1,69 @@
+/***************************************************************************
+    Streaming WAV Playback.
+
+    Plays a looping WAV file without loading it up front. The file is
+    memory mapped, and a background thread converts it to the output
+    format and sample rate in small chunks, using an SDL_AudioStream.
+
+    Converted audio is placed in a fixed size ring buffer, so memory use
+    does not depend on the length of the track.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <SDL.h>
+
+#include "mappedfile.hpp"
+
+class WavStream
+{
+public:
+    WavStream();
+    ~WavStream();
+
+    // Open a WAV file and start converting it in the background.
+    // Returns false if the file cannot be streamed.
+    bool open(const char* filename, int rate, int channels);
+    void close();
+    bool is_open() const { return running; }
+
+    // Read converted 16-bit samples. Any samples not yet converted are output as silence.
+    // samples: Number of int16 values to read
+    void read(int16_t* dst, uint32_t samples);
+
+private:
+    // Bytes of source WAV data converted per step
+    static const uint32_t CHUNK_BYTES = 4096;
+
+    MappedFile file;
+
+    // Source sample data within the mapped file
+    const uint8_t* src_data;
+    uint32_t src_length;
+    uint32_t src_pos;
+
+    SDL_AudioStream* stream;
+
+    // Ring buffer of converted samples. Positions only ever increase (and wrap).
+    int16_t* ring;
+    uint32_t ring_size;
+    std::atomic<uint32_t> read_pos;
+    std::atomic<uint32_t> write_pos;
+
+    // Background conversion thread
+    std::thread worker;
+    std::atomic<bool> running;
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+
+    bool parse_header(SDL_AudioFormat& format, int& channels, int& freq);
+    void produce();
+    void fail(const char* stage);
+};
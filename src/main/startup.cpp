@@ -0,0 +1,127 @@
+/***************************************************************************
+    Start-up Tasks.
+
+    Runs the start-up phases as a small task graph. Tasks that don't need
+    the main thread (reading, checking and decoding ROMs) run on worker
+    threads, while SDL, the window and the controller database initialise
+    on the main thread.
+
+    Each task is timed, so a report of the start-up phases can be shown.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+
+#include "startup.hpp"
+
+Startup::Startup()
+{
+    t0 = clock::now();
+}
+
+Startup::~Startup()
+{
+    wait_all();
+}
+
+double Startup::elapsed_ms() const
+{
+    return std::chrono::duration<double, std::milli>(clock::now() - t0).count();
+}
+
+Startup::task_t* Startup::add(const char* name, bool worker, std::initializer_list<int> after, std::vector<std::shared_future<bool>>& deps)
+{
+    for (auto id : after)
+        deps.push_back(tasks[id].result);
+
+    tasks.push_back(task_t());
+    task_t* t   = &tasks.back();
+    t->name     = name;
+    t->worker   = worker;
+    t->start_ms = 0;
+    t->end_ms   = 0;
+    return t;
+}
+
+int Startup::start(const char* name, std::function<bool()> task, std::initializer_list<int> after)
+{
+    std::vector<std::shared_future<bool>> deps;
+    task_t* t = add(name, true, after, deps);
+
+    auto done = std::make_shared<std::promise<bool>>();
+    t->result = done->get_future().share();
+
+    threads.push_back(std::thread([this, t, task, deps, done]()
+    {
+        bool ok = true;
+        for (size_t i = 0; i < deps.size(); i++)
+            ok &= deps[i].get();
+
+        t->start_ms = elapsed_ms();
+        if (ok)
+            ok = task();
+        t->end_ms = elapsed_ms();
+
+        done->set_value(ok);
+    }));
+
+    return (int) tasks.size() - 1;
+}
+
+bool Startup::run(const char* name, std::function<bool()> task, std::initializer_list<int> after)
+{
+    std::vector<std::shared_future<bool>> deps;
+    task_t* t = add(name, false, after, deps);
+
+    bool ok = true;
+    for (size_t i = 0; i < deps.size(); i++)
+        ok &= deps[i].get();
+
+    t->start_ms = elapsed_ms();
+    if (ok)
+        ok = task();
+    t->end_ms = elapsed_ms();
+
+    std::promise<bool> done;
+    done.set_value(ok);
+    t->result = done.get_future().share();
+    return ok;
+}
+
+bool Startup::wait(int id)
+{
+    return tasks[id].result.get();
+}
+
+void Startup::wait_all()
+{
+    for (size_t i = 0; i < threads.size(); i++)
+    {
+        if (threads[i].joinable())
+            threads[i].join();
+    }
+}
+
+void Startup::report()
+{
+    wait_all();
+
+    // Formatted separately, so std::cout's format state is left unchanged
+    std::ostringstream report;
+    report << "Start-up timing (ms): start, end, duration" << std::endl;
+    report << std::fixed << std::setprecision(1);
+
+    for (size_t i = 0; i < tasks.size(); i++)
+    {
+        const task_t& t = tasks[i];
+        report << "  " << std::left  << std::setw(18) << t.name << std::setw(7) << (t.worker ? "worker" : "main")
+               << std::right << std::setw(8) << t.start_ms << std::setw(8) << t.end_ms << std::setw(8) << (t.end_ms - t.start_ms) << std::endl;
+    }
+    report << "  " << std::left << std::setw(25) << "First frame" << std::right << std::setw(8) << elapsed_ms() << std::endl;
+    std::cout << report.str();
+}
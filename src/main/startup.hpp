@@ -0,0 +1,68 @@
+/***************************************************************************
+    Start-up Tasks.
+
+    Runs the start-up phases as a small task graph. Tasks that don't need
+    the main thread (reading, checking and decoding ROMs) run on worker
+    threads, while SDL, the window and the controller database initialise
+    on the main thread.
+
+    Each task is timed, so a report of the start-up phases can be shown.
+
+    Copyright Chris White.
+    See license.txt for more details.
+***************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <future>
+#include <initializer_list>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Startup
+{
+public:
+    Startup();
+    ~Startup();
+
+    // Start a task on a worker thread, once the tasks it depends on have completed.
+    // The task is skipped, and fails, if any of them failed. Returns an id for the task.
+    int start(const char* name, std::function<bool()> task, std::initializer_list<int> after = {});
+
+    // Run a task on this thread, once the tasks it depends on have completed. Returns true on success.
+    bool run(const char* name, std::function<bool()> task, std::initializer_list<int> after = {});
+
+    // Wait for a task to complete. Returns true on success.
+    bool wait(int id);
+
+    // Wait for all worker tasks to complete
+    void wait_all();
+
+    // Print the start and end of each task, relative to the creation of this object
+    void report();
+
+private:
+    typedef std::chrono::steady_clock clock;
+
+    struct task_t
+    {
+        std::string name;
+        bool worker;
+        double start_ms;
+        double end_ms;
+        std::shared_future<bool> result;
+    };
+
+    clock::time_point t0;
+
+    // Deque, as references to existing tasks stay valid when a task is added
+    std::deque<task_t> tasks;
+    std::vector<std::thread> threads;
+
+    task_t* add(const char* name, bool worker, std::initializer_list<int> after, std::vector<std::shared_future<bool>>& deps);
+    double elapsed_ms() const;
+};
@@ -14,6 +14,7 @@
 
 #include <iostream>
 #include "trackloader.hpp"
+#include "savestate.hpp"
 #include "roms.hpp"
 #include "engine/outrun.hpp"
 #include "engine/oaddresses.hpp"
@@ -81,19 +82,191 @@ void TrackLoader::init(bool jap)
 
 bool TrackLoader::set_layout_track(const char* filename)
 {
-    if (layout == NULL)
+    if (layout != NULL)
         delete layout;
 
     layout = new RomLoader();
     
-    if (layout->load_binary(filename))
+    // Map the file, rather than reading it. Track data is only read.
+    if (!layout_file.open(filename))
+    {
+        std::cout << "Unable to open LayOut track: " << filename << std::endl;
+        delete layout;
+        layout = NULL;
+        mode   = MODE_ORIGINAL;
         return false;
+    }
+
+    layout->use_shared(layout_file.data, (uint32_t) layout_file.length);
+
+    // Check once that every table is within the file, so reads during play need no checks
+    if (!check_layout())
+    {
+        std::cout << "Invalid LayOut track: " << filename << std::endl;
+        delete layout;
+        layout = NULL;
+        layout_file.close();
+        mode   = MODE_ORIGINAL;
+        return false;
+    }
 
     mode = MODE_LAYOUT;
 
     return true;
 }
 
+// Check the header offsets, and the tables they point to, are within the LayOut file
+bool TrackLoader::check_layout()
+{
+    const uint32_t length = layout->length;
+
+    if (LayOut::HEIGHT_MAPS + sizeof(uint32_t) > length)
+        return false;
+
+    // Paths for all stages are stored together
+    const uint32_t PATH_ADR = layout->read32(LayOut::PATH);
+    if ((uint64_t) PATH_ADR + (ROAD_END_CPU1 * sizeof(uint32_t) * STAGES) > length)
+        return false;
+
+    static const uint32_t TABLES[] = { LayOut::END_PATH, LayOut::SPLIT_PATH, LayOut::PAL_SKY, LayOut::PAL_GND, LayOut::SPRITE_MAPS, LayOut::HEIGHT_MAPS };
+    for (uint32_t i = 0; i < sizeof(TABLES) / sizeof(uint32_t); i++)
+    {
+        if (layout->read32(TABLES[i]) >= length)
+            return false;
+    }
+
+    for (int i = 0; i < STAGES; i++)
+    {
+        if (!check_layout_level(layout->read32(LayOut::LEVELS + (i * sizeof(uint32_t))), true))
+            return false;
+    }
+
+    for (int i = 0; i < 5; i++)
+    {
+        if (!check_layout_level(layout->read32(LayOut::END_LEVELS + (i * sizeof(uint32_t))), false))
+            return false;
+    }
+
+    return check_layout_level(layout->read32(LayOut::SPLIT_LEVEL), false);
+}
+
+// Check a level (see setup_level) or special section (see setup_section)
+bool TrackLoader::check_layout_level(const uint32_t STAGE_ADR, bool palettes)
+{
+    const uint32_t entries = palettes ? 9 : 3;
+
+    if (!in_layout(STAGE_ADR, entries * sizeof(uint32_t)))
+        return false;
+
+    // Sky palette, four pairs of road palette entries and ground palette
+    if (palettes)
+    {
+        static const uint32_t SIZES[] = { 2, 8, 8, 8, 8, 2 };
+        for (uint32_t i = 0; i < 6; i++)
+        {
+            if (!in_layout(layout->read32(STAGE_ADR + (i * 4)), SIZES[i]))
+                return false;
+        }
+
+        // Sky and ground palettes are indexes into the shared palette tables
+        if (!in_layout(layout->read32(LayOut::PAL_SKY) + ((uint64_t) layout->read16(layout->read32(STAGE_ADR + 0))  * 4), 4) ||
+            !in_layout(layout->read32(LayOut::PAL_GND) + ((uint64_t) layout->read16(layout->read32(STAGE_ADR + 20)) * 4), 4))
+            return false;
+    }
+
+    // Walk the curve, width/height and scenery lists to their end. The road position never passes the end of
+    // the road path, so entries positioned after it are never read.
+    const uint32_t CURVE_ADR = STAGE_ADR + ((entries - 3) * 4);
+    return check_layout_curve(layout->read32(CURVE_ADR)) &&
+           check_layout_width_height(layout->read32(CURVE_ADR + 4)) &&
+           check_layout_scenery(layout->read32(CURVE_ADR + 8));
+}
+
+// Curve data: 6 byte entries (see OInitEngine::update_road), ended by a position of -1.
+// The next curve is read 0x3C positions early.
+bool TrackLoader::check_layout_curve(uint32_t adr)
+{
+    while (true)
+    {
+        if (!in_layout(adr, 2))
+            return false;
+
+        const int16_t pos = (int16_t) layout->read16(adr);
+        if (pos == -1 || pos - 0x3C > (int16_t) ROAD_END_CPU1)
+            return true;
+
+        if (!in_layout(adr, 6))
+            return false;
+        adr += 6;
+    }
+}
+
+// Width/height data: 8 byte entries (see OInitEngine::update_road).
+// A height entry holds an index into the height map table.
+bool TrackLoader::check_layout_width_height(uint32_t adr)
+{
+    const uint32_t HEIGHT_MAPS = layout->read32(LayOut::HEIGHT_MAPS);
+
+    while (true)
+    {
+        if (!in_layout(adr, 2))
+            return false;
+
+        if (layout->read16(adr) > ROAD_END_CPU1)
+            return true;
+
+        if (!in_layout(adr, 8))
+            return false;
+
+        // Height map entry: Control byte, step byte and at least one word of data (see ORoad::init_height_seg)
+        if (layout->read16(adr + 2) == 0)
+        {
+            const uint64_t entry = HEIGHT_MAPS + ((uint64_t) layout->read16(adr + 4) * 4);
+            if (!in_layout(entry, 4) || !in_layout(layout->read32((uint32_t) entry), 4))
+                return false;
+        }
+        adr += 8;
+    }
+}
+
+// Scenery data: 4 byte entries (see OSprites::sprite_control).
+// Each holds an index into the sprite map table.
+bool TrackLoader::check_layout_scenery(uint32_t adr)
+{
+    const uint32_t SPRITE_MAPS = layout->read32(LayOut::SPRITE_MAPS);
+
+    while (true)
+    {
+        if (!in_layout(adr, 2))
+            return false;
+
+        if (layout->read16(adr) > ROAD_END_CPU1)
+            return true;
+
+        if (!in_layout(adr, 4))
+            return false;
+
+        // Sprite map entry: Frequency, offset of the last sprite, then 8 bytes per sprite (see OLevelObjs::setup_sprite)
+        const uint64_t entry = SPRITE_MAPS + ((uint64_t) layout->read8(adr + 3) * 4);
+        if (!in_layout(entry, 4))
+            return false;
+
+        const uint32_t map = layout->read32((uint32_t) entry);
+        if (!in_layout(map, 4))
+            return false;
+
+        const int16_t last_sprite = (int16_t) layout->read16(map + 2);
+        if (last_sprite < 0 || !in_layout((uint64_t) map + 4 + last_sprite, 8))
+            return false;
+        adr += 4;
+    }
+}
+
+bool TrackLoader::in_layout(uint64_t adr, uint32_t size)
+{
+    return adr + size <= layout->length;
+}
+
 void TrackLoader::init_original_tracks(bool jap)
 {
     stage_data = jap ? STAGE_MAPPING_JAP : STAGE_MAPPING_USA;
@@ -139,7 +312,7 @@ void TrackLoader::init_original_tracks(bool jap)
 
         // CPU 1 Data
         const uint32_t PATH_ADR = roms.rom1p->read32(ROAD_DATA_LOOKUP + STAGE_OFFSET);
-        levels[i].path = &roms.rom1p->rom[PATH_ADR];        
+        decode_path(levels[i].path, roms.rom1p, PATH_ADR);
     }
 
     // --------------------------------------------------------------------------------------------
@@ -148,14 +321,16 @@ void TrackLoader::init_original_tracks(bool jap)
 
     // Split stages don't contain palette information
     setup_section(level_split, roms.rom0p, outrun.adr.road_seg_split);
-    level_split->path         = &roms.rom1p->rom[ROAD_DATA_SPLIT];
+    decode_path(level_split->path, roms.rom1p, ROAD_DATA_SPLIT);
 
     for (int i = 0; i < 5; i++)
     {
         const uint32_t STAGE_ADR = roms.rom0p->read32(outrun.adr.road_seg_end + (i << 2));
         setup_section(&levels_end[i], roms.rom0p, STAGE_ADR);
-        levels_end[i].path  = &roms.rom1p->rom[ROAD_DATA_BONUS];
     }
+
+    // End sections share a path, held by the first
+    decode_path(levels_end[0].path, roms.rom1p, ROAD_DATA_BONUS);
 }
 
 void TrackLoader::init_layout_tracks(bool jap)
@@ -204,7 +379,7 @@ void TrackLoader::init_layout_tracks(bool jap)
 
         // CPU 1 Data
         const uint32_t PATH_ADR = layout->read32(LayOut::PATH);
-        levels[i].path = &layout->rom[ PATH_ADR + ((ROAD_END_CPU1 * sizeof(uint32_t)) * i) ];
+        decode_path(levels[i].path, layout, PATH_ADR + ((ROAD_END_CPU1 * sizeof(uint32_t)) * i));
     }
 
     // --------------------------------------------------------------------------------------------
@@ -213,16 +388,15 @@ void TrackLoader::init_layout_tracks(bool jap)
 
     // Split stages don't contain palette information
     setup_section(level_split, layout, layout->read32(LayOut::SPLIT_LEVEL));
-    level_split->path = &layout->rom[ layout->read32(LayOut::SPLIT_PATH) ];
+    decode_path(level_split->path, layout, layout->read32(LayOut::SPLIT_PATH));
 
-    // End sections don't contain palette information. Shared path.
-    uint8_t* end_path = &layout->rom[ layout->read32(LayOut::END_PATH) ];
+    // End sections don't contain palette information. Shared path, held by the first.
     for (int i = 0; i < 5; i++)
     {
         const uint32_t STAGE_ADR = layout->read32(LayOut::END_LEVELS + (i * sizeof(uint32_t)));
         setup_section(&levels_end[i], layout, STAGE_ADR);
-        levels_end[i].path = end_path;
     }
+    decode_path(levels_end[0].path, layout, layout->read32(LayOut::END_PATH));
 }
 
 // Setup a normal level
@@ -253,17 +427,8 @@ void TrackLoader::setup_level(Level* l, RomLoader* data, const int STAGE_ADR)
     adr = data->read32(STAGE_ADR + 20);
     l->pal_gnd = data->read16(adr);
 
-    // Curve Data
-    curve_offset = data->read32(STAGE_ADR + 24);
-    l->curve = &data->rom[curve_offset];
-
-    // Width / Height Lookup
-    wh_offset = data->read32(STAGE_ADR + 28);
-    l->width_height = &data->rom[wh_offset];
-
-    // Sprite Information
-    scenery_offset = data->read32(STAGE_ADR + 32);
-    l->scenery = &data->rom[scenery_offset];
+    // Curve, Width / Height and Sprite Information
+    setup_section(l, data, STAGE_ADR + 24);
 }
 
 // Setup a special section of track (end section or level split)
@@ -271,16 +436,43 @@ void TrackLoader::setup_level(Level* l, RomLoader* data, const int STAGE_ADR)
 void TrackLoader::setup_section(Level* l, RomLoader* data, const int STAGE_ADR)
 {
     // Curve Data
-    curve_offset = data->read32(STAGE_ADR + 0);
-    l->curve = &data->rom[curve_offset];
+    decode_list(l->curve, data, data->read32(STAGE_ADR + 0), 3, true);
 
     // Width / Height Lookup
-    wh_offset = data->read32(STAGE_ADR + 4);
-    l->width_height = &data->rom[wh_offset];
+    decode_list(l->width_height, data, data->read32(STAGE_ADR + 4), 4, false);
 
     // Sprite Information
-    scenery_offset = data->read32(STAGE_ADR + 8);
-    l->scenery = &data->rom[scenery_offset];
+    decode_list(l->scenery, data, data->read32(STAGE_ADR + 8), 2, false);
+}
+
+// Decode a road path: ROAD_END_CPU1 pairs of x,y words. Words past the end of the data are zero.
+void TrackLoader::decode_path(std::vector<int16_t>& out, RomLoader* data, uint32_t adr)
+{
+    out.assign(ROAD_END_CPU1 * 2, 0);
+    for (uint32_t i = 0; i < out.size() && (uint64_t) adr + 2 <= data->length; i++, adr += 2)
+        out[i] = data->read16(adr);
+}
+
+// Decode a list of curve (3 word), width/height (4 word) or scenery (2 word) entries, up to and including
+// the entry that ends it. The road position never passes the end of the road path, so later entries are
+// never read. A list that runs off the end of the data is ended there.
+void TrackLoader::decode_list(std::vector<int16_t>& out, RomLoader* data, uint32_t adr, const uint32_t words, bool curve)
+{
+    out.clear();
+
+    while ((uint64_t) adr + (words * 2) <= data->length)
+    {
+        const int16_t pos = data->read16(adr);
+        for (uint32_t i = 0; i < words; i++, adr += 2)
+            out.push_back(data->read16(adr));
+
+        // The next curve is read 0x3C positions early
+        if (curve ? (pos == -1 || pos - 0x3C > (int16_t) ROAD_END_CPU1) : (uint16_t) pos > ROAD_END_CPU1)
+            return;
+    }
+
+    out.push_back(-1);
+    out.resize(out.size() + words - 1, 0);
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -324,60 +516,74 @@ void TrackLoader::init_track_bonus(const uint32_t id)
 
 void TrackLoader::init_path(const uint32_t offset)
 {
-    current_path = levels[stage_offset_to_level(offset)].path;
+    current_path = levels[stage_offset_to_level(offset)].path.data();
 }
 
 void TrackLoader::init_path_split()
 {
-    current_path = level_split->path;
+    current_path = level_split->path.data();
 }
 
 void TrackLoader::init_path_end()
 {
-    current_path = levels_end[0].path; // Path is shared for end sections
+    current_path = levels_end[0].path.data(); // Path is shared for end sections
+}
+
+// Current level, road path and position in the level's data. Everything else is set at load,
+// or when a course is selected from the menu.
+void TrackLoader::add_state(SaveState& state)
+{
+    state.add(current_level);
+    state.add(current_path);
+    state.add(curve_offset);
+    state.add(wh_offset);
+    state.add(scenery_offset);
 }
 
 // ------------------------------------------------------------------------------------------------
 //                                        HELPER FUNCTIONS TO READ DATA
 // ------------------------------------------------------------------------------------------------
 
+// Level data is decoded at load (see decode_path and decode_list), so these are indexed loads.
+// Addresses and offsets are in bytes, and always even.
+
 int16_t TrackLoader::readPath(uint32_t addr)
 {
-    return (current_path[addr] << 8) | current_path[addr+1];
+    return current_path[addr >> 1];
 }
 
 int16_t TrackLoader::readPath(uint32_t* addr)
 {
-    int16_t value = (current_path[*addr] << 8) | (current_path[*addr+1]);
+    int16_t value = current_path[*addr >> 1];
     *addr += 2;
     return value;
 }
 
 int16_t TrackLoader::read_width_height(uint32_t* addr)
 {
-    int16_t value = (current_level->width_height[*addr + wh_offset] << 8) | (current_level->width_height[*addr+1 + wh_offset]);
+    int16_t value = current_level->width_height[(*addr + wh_offset) >> 1];
     *addr += 2;
     return value;
 }
 
 int16_t TrackLoader::read_curve(uint32_t addr)
 {
-    return (current_level->curve[addr + curve_offset] << 8) | current_level->curve[addr+1 + curve_offset];
+    return current_level->curve[(addr + curve_offset) >> 1];
 }
 
 uint16_t TrackLoader::read_scenery_pos()
 {
-    return (current_level->scenery[scenery_offset] << 8) | current_level->scenery[scenery_offset + 1];
+    return current_level->scenery[scenery_offset >> 1];
 }
 
 uint8_t TrackLoader::read_total_sprites()
 {
-    return current_level->scenery[scenery_offset + 2];
+    return (uint16_t) current_level->scenery[(scenery_offset >> 1) + 1] >> 8;
 }
 
 uint8_t TrackLoader::read_sprite_pattern_index()
 {
-    return current_level->scenery[scenery_offset + 3];
+    return current_level->scenery[(scenery_offset >> 1) + 1] & 0xFF;
 }
 
 Level* TrackLoader::get_level(uint32_t id)
@@ -14,7 +14,12 @@
 
 #pragma once
 
+#include <vector>
 #include "globals.hpp"
+#include "mappedfile.hpp"
+#include "romloader.hpp"
+
+class SaveState;
 
 // Road Generator Palette Representation
 struct RoadPalette
@@ -26,12 +31,13 @@ struct RoadPalette
 };
 
 // OutRun Level Representation
+// Road data is decoded to native-endian words at load. Offsets into it are in bytes, as in the ROM.
 struct Level
 {
-    uint8_t* path;            // CPU 1 Path Data
-    uint8_t* curve;           // Track Curve Information (Derived From Path)
-    uint8_t* width_height;    // Track Width & Height Lookups
-    uint8_t* scenery;         // Track Scenery Lookups
+    std::vector<int16_t> path;         // CPU 1 Path Data
+    std::vector<int16_t> curve;        // Track Curve Information (Derived From Path)
+    std::vector<int16_t> width_height; // Track Width & Height Lookups
+    std::vector<int16_t> scenery;      // Track Scenery Lookups
 
     uint16_t pal_sky;         // Index into Sky Palettes
     uint16_t pal_gnd;         // Index into Ground Palettes
@@ -58,8 +64,6 @@ struct LayOut
     static const uint32_t HEIGHT_MAPS = SPRITE_MAPS + sizeof(uint32_t);
 };
 
-class RomLoader;
-
 class TrackLoader
 {
 
@@ -104,6 +108,7 @@ public:
     void init_path(const uint32_t);
     void init_path_split();
     void init_path_end();
+    void add_state(SaveState& state);
 
     uint32_t read_pal_sky_table(uint16_t entry);
     uint32_t read_pal_gnd_table(uint16_t entry);    
@@ -121,16 +126,17 @@ public:
     int8_t stage_offset_to_level(uint32_t);
     Level* get_level(uint32_t);
 
+    // Big-endian reads. Each is a single load, byte-swapped to native order if required.
     inline int32_t read32(uint8_t* data, uint32_t* addr)
     {    
-        int32_t value = (data[*addr] << 24) | (data[*addr+1] << 16) | (data[*addr+2] << 8) | (data[*addr+3]);
+        int32_t value = read32(data, *addr);
         *addr += 4;
         return value;
     }
 
     inline int16_t read16(uint8_t* data, uint32_t* addr)
     {
-        int16_t value = (data[*addr] << 8) | (data[*addr+1]);
+        int16_t value = read16(data, *addr);
         *addr += 2;
         return value;
     }
@@ -142,12 +148,16 @@ public:
 
     inline int32_t read32(uint8_t* data, uint32_t addr)
     {    
-        return (data[addr] << 24) | (data[addr+1] << 16) | (data[addr+2] << 8) | data[addr+3];
+        uint32_t value;
+        memcpy(&value, data + addr, sizeof(value));
+        return ROM_FROM_BE32(value);
     }
 
     inline int16_t read16(uint8_t* data, uint32_t addr)
     {
-        return (data[addr] << 8) | data[addr+1];
+        uint16_t value;
+        memcpy(&value, data + addr, sizeof(value));
+        return ROM_FROM_BE16(value);
     }
 
     inline int8_t read8(uint8_t* data, uint32_t addr)
@@ -159,16 +169,27 @@ public:
 private:
     RomLoader* layout;
 
+    // LayOut file, mapped in place rather than read into memory
+    MappedFile layout_file;
+
     int mode;
 
     Level* levels;         // Normal Stages 
     Level* level_split;    // Split Section
     Level* levels_end;     // End Section
 
-    uint8_t* current_path; // CPU 1 Road Path
+    const int16_t* current_path; // CPU 1 Road Path
     
     void setup_level(Level* l, RomLoader* data, const int STAGE_ADR);
     void setup_section(Level* l, RomLoader* data, const int STAGE_ADR);
+    void decode_path(std::vector<int16_t>& out, RomLoader* data, uint32_t adr);
+    void decode_list(std::vector<int16_t>& out, RomLoader* data, uint32_t adr, const uint32_t words, bool curve);
+    bool check_layout();
+    bool check_layout_level(const uint32_t STAGE_ADR, bool palettes);
+    bool check_layout_curve(uint32_t adr);
+    bool check_layout_width_height(uint32_t adr);
+    bool check_layout_scenery(uint32_t adr);
+    bool in_layout(uint64_t adr, uint32_t size);
 };
 
 extern TrackLoader trackloader;
\ No newline at end of file
@@ -5,9 +5,15 @@
     See license.txt for more details.
 ***************************************************************************/
 
+#include <fstream>
+#include <iostream>
 #include <sstream>
 #include "utils.hpp"
 
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
 // Convert value to string
 std::string Utils::to_string(int i)
 {
@@ -42,4 +48,25 @@ uint32_t Utils::from_hex_string(std::string s)
     ss >> x;
     // output it as a signed type
     return static_cast<unsigned int>(x);
-}
\ No newline at end of file
+}
+
+uint64_t Utils::get_rss()
+{
+#ifdef __linux__
+    // Second field is the resident set size, in pages
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size = 0, resident = 0;
+    if (statm >> size >> resident)
+        return resident * (uint64_t) sysconf(_SC_PAGESIZE);
+#endif
+    return 0;
+}
+
+void Utils::report_rss(const char* when)
+{
+    const uint64_t rss = get_rss();
+    if (rss)
+        std::cout << "RSS after " << when << ": " << (rss >> 10) << " KB" << std::endl;
+    else
+        std::cout << "RSS after " << when << ": unavailable" << std::endl;
+}
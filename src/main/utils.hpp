@@ -18,5 +18,9 @@ public:
     static std::string to_hex_string(int i);
     static uint32_t from_hex_string(std::string s);
 
+    // Resident set size of this process in bytes (0 if unavailable)
+    static uint64_t get_rss();
+    static void report_rss(const char* when);
+
 private:
 };
\ No newline at end of file
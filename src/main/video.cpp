@@ -9,12 +9,17 @@
     See license.txt for more details.
 ***************************************************************************/
 
+#include <chrono>
+#include <cstring>
 #include <iostream>
+#include <thread>
 
 #include "video.hpp"
 #include "globals.hpp"
 #include "frontend/config.hpp"
 #include "engine/oroad.hpp"
+#include "savestate.hpp"
+#include "realtime.hpp"
 
 #ifdef WITH_OPENGL
 #include "sdl2/rendergl.hpp"
@@ -30,8 +35,18 @@ Video::Video(void)
 {
     renderer     = new Render();
     pixels       = NULL;
+    pipeline_depth = 1;
+    for (int i = 0; i < PIPELINE_MAX; i++)
+    {
+        frame_pixels[i]  = NULL;
+        frame_palette[i] = NULL;
+    }
+    frames_submitted = 0;
+    frames_presented = 0;
+    render_running   = false;
     sprite_layer = new hwsprites();
     tile_layer   = new hwtiles();
+    cache_shared = false;
 
     set_shadow_intensity(shadow::ORIGINAL);
     enabled      = false;
@@ -39,55 +54,199 @@ Video::Video(void)
 
 Video::~Video(void)
 {
+    stop_pipeline();
     delete sprite_layer;
     delete tile_layer;
-    if (pixels) delete[] pixels;
+    free_frames();
     renderer->disable();
     delete renderer;
 }
 
-int Video::init(Roms* roms, video_settings_t* settings)
+// ------------------------------------------------------------------------------------------------
+// Cache of decoded tiles, sprites and road graphics, plus the program ROMs.
+// When present, the video ROMs do not need to be loaded or decoded at start-up.
+//
+// With shared assets enabled, the cache is used in place rather than copied. The pages are
+// read-only and backed by the file, so every instance on the machine shares one copy.
+// ------------------------------------------------------------------------------------------------
+
+static const uint32_t CACHE_LENGTHS[AssetCache::SECTIONS] =
 {
-    if (!set_video_mode(settings))
-        return 0;
+    hwtiles::TILES_LENGTH * sizeof(uint32_t),
+    hwsprites::SPRITES_LENGTH * sizeof(uint32_t),
+    HWRoad::ROADS_LENGTH,
+    Roms::ROM0_LENGTH,
+    Roms::ROM1_LENGTH,
+    Roms::Z80_LENGTH,
+    Roms::PCM_LENGTH,
+};
+
+// Returns true if the cache is valid, in which case the video ROMs need not be loaded.
+// With shared assets, the program ROMs are also mapped from the cache and need not be loaded.
+bool Video::open_cache(Roms* roms)
+{
+    cache_shared = false;
 
-    // Internal pixel array. The size of this is always constant
-    if (pixels) delete[] pixels;
-    pixels = new uint16_t[config.s16_width * config.s16_height];
+    if (!config.data.video_cache)
+        return false;
+
+    if (!cache.open(config.data.file_video_cache, roms->rom_key(config.sound.fix_samples) + CACHE_FORMAT, CACHE_LENGTHS, AssetCache::SECTIONS))
+        return false;
+
+    if (config.data.shared_assets)
+    {
+        roms->rom0.use_shared(cache.get(AssetCache::ROM0), CACHE_LENGTHS[AssetCache::ROM0]);
+        roms->rom1.use_shared(cache.get(AssetCache::ROM1), CACHE_LENGTHS[AssetCache::ROM1]);
+        roms->z80.use_shared(cache.get(AssetCache::Z80), CACHE_LENGTHS[AssetCache::Z80]);
+        roms->pcm.use_shared(cache.get(AssetCache::PCM), CACHE_LENGTHS[AssetCache::PCM]);
+        cache_shared = true;
+    }
+    return true;
+}
+
+void Video::save_cache(Roms* roms)
+{
+    const AssetCache::section_t sections[AssetCache::SECTIONS] =
+    {
+        { tile_layer->get_decoded(),   CACHE_LENGTHS[AssetCache::TILES]   },
+        { sprite_layer->get_decoded(), CACHE_LENGTHS[AssetCache::SPRITES] },
+        { hwroad.get_decoded(),        CACHE_LENGTHS[AssetCache::ROAD]    },
+        { roms->rom0.rom,              CACHE_LENGTHS[AssetCache::ROM0]    },
+        { roms->rom1.rom,              CACHE_LENGTHS[AssetCache::ROM1]    },
+        { roms->z80.rom,               CACHE_LENGTHS[AssetCache::Z80]     },
+        { roms->pcm.rom,               CACHE_LENGTHS[AssetCache::PCM]     },
+    };
+
+    if (!AssetCache::save(config.data.file_video_cache, roms->rom_key(config.sound.fix_samples) + CACHE_FORMAT, sections, AssetCache::SECTIONS))
+        std::cout << "Unable to write video cache: " << config.data.file_video_cache << std::endl;
+}
+
+// Decode the tiles, sprites and road from the cache or ROMs. The ROMs are freed once decoded.
+// Does not depend on the video mode, so can run on a worker thread while the window is created.
+void Video::decode(Roms* roms)
+{
+    // Decoded graphics from the cache, or the ROMs to decode them from
+    const bool cached = cache.is_open();
+    const bool decode = roms->tiles.rom && roms->sprites.rom && roms->road.rom;
+
+    if (cache_shared)
+    {
+        tile_layer->use_shared((const uint32_t*) cache.get(AssetCache::TILES));
+        sprite_layer->use_shared((const uint32_t*) cache.get(AssetCache::SPRITES));
+        hwroad.use_shared(cache.get(AssetCache::ROAD));
+    }
+    else if (cached)
+    {
+        tile_layer->set_decoded((const uint32_t*) cache.get(AssetCache::TILES));
+        sprite_layer->set_decoded((const uint32_t*) cache.get(AssetCache::SPRITES));
+        hwroad.set_decoded(cache.get(AssetCache::ROAD));
+    }
+    else if (decode)
+    {
+        // Convert S16 sprites and road alongside the tiles
+        std::thread sprite_thread([&]() { sprite_layer->decode(roms->sprites.rom); });
+        std::thread road_thread([&]()   { hwroad.decode_road(roms->road.rom); });
+        tile_layer->decode(roms->tiles.rom);
+        sprite_thread.join();
+        road_thread.join();
+    }
 
-    // Convert S16 tiles to a more useable format
-    tile_layer->init(roms->tiles.rom, config.video.hires != 0);
-    
-    clear_tile_ram();
-    clear_text_ram();
     if (roms->tiles.rom)
     {
         delete[] roms->tiles.rom;
         roms->tiles.rom = NULL;
     }
-
-    // Convert S16 sprites
-    sprite_layer->init(roms->sprites.rom);
     if (roms->sprites.rom)
     {
         delete[] roms->sprites.rom;
         roms->sprites.rom = NULL;
     }
-
-    // Convert S16 Road Stuff
-    hwroad.init(roms->road.rom, config.video.hires != 0);
     if (roms->road.rom)
     {
         delete[] roms->road.rom;
         roms->road.rom = NULL;
     }
 
+    // Unless shared, the cache is copied into place, so can be unmapped. Write a new cache if the ROMs were decoded.
+    if (cached && !cache_shared)
+        cache.close();
+    else if (decode && config.data.video_cache)
+    {
+        save_cache(roms);
+
+        // Low memory: Swap the decoded graphics for the cache just written, which is file backed and can be paged out
+        if (config.data.low_memory && cache.open(config.data.file_video_cache, roms->rom_key(config.sound.fix_samples) + CACHE_FORMAT, CACHE_LENGTHS, AssetCache::SECTIONS))
+        {
+            tile_layer->use_shared((const uint32_t*) cache.get(AssetCache::TILES));
+            sprite_layer->use_shared((const uint32_t*) cache.get(AssetCache::SPRITES));
+            hwroad.use_shared(cache.get(AssetCache::ROAD));
+            cache_shared = true;
+        }
+    }
+}
+
+int Video::init(Roms* roms, video_settings_t* settings)
+{
+    if (!set_video_mode(settings))
+        return 0;
+
+    return init_layers(roms);
+}
+
+// Set up the layers for the current video mode. Decodes the graphics, if not already done.
+int Video::init_layers(Roms* roms)
+{
+    stop_pipeline();
+    free_frames();
+
+    pipeline_depth = config.video.pipeline;
+    if (pipeline_depth < 1) pipeline_depth = 1;
+    else if (pipeline_depth > PIPELINE_MAX) pipeline_depth = PIPELINE_MAX;
+
+    if (pipeline_depth > 1 && !renderer->supports_render_thread())
+    {
+        std::cout << "Pipelined rendering is not supported by this renderer." << std::endl;
+        pipeline_depth = 1;
+    }
+
+    // Internal pixel arrays. The size of these is always constant
+    for (int i = 0; i < pipeline_depth; i++)
+    {
+        frame_pixels[i] = new uint16_t[config.s16_width * config.s16_height];
+        if (pipeline_depth > 1)
+            frame_palette[i] = new uint32_t[S16_PALETTE_ENTRIES * 2];
+    }
+    pixels = frame_pixels[0];
+    frames_submitted = 0;
+    frames_presented = 0;
+
+    decode(roms);
+
+    tile_layer->init(NULL, config.video.hires != 0);
+    clear_tile_ram();
+    clear_text_ram();
+    sprite_layer->init(NULL);
+    hwroad.init(NULL, config.video.hires != 0);
+
     enabled = true;
     return 1;
 }
 
+void Video::free_frames()
+{
+    for (int i = 0; i < PIPELINE_MAX; i++)
+    {
+        if (frame_pixels[i])  delete[] frame_pixels[i];
+        if (frame_palette[i]) delete[] frame_palette[i];
+        frame_pixels[i]  = NULL;
+        frame_palette[i] = NULL;
+    }
+    pixels = NULL;
+}
+
 void Video::disable()
 {
+    stop_pipeline();
     renderer->disable();
     enabled = false;
 }
@@ -111,6 +270,10 @@ int Video::set_video_mode(video_settings_t* settings)
 
     config.s16_height = S16_HEIGHT;
 
+    // Low memory: Don't quadruple the pixel buffers
+    if (config.data.low_memory)
+        settings->hires = 0;
+
     // Internal video buffer is doubled in hi-res mode.
     if (settings->hires)
     {
@@ -126,6 +289,7 @@ int Video::set_video_mode(video_settings_t* settings)
 
     set_shadow_intensity(settings->shadow == 0 ? shadow::ORIGINAL : shadow::MAME);
 
+    stop_pipeline();
     renderer->init(config.s16_width, config.s16_height, settings->scale, settings->mode, settings->scanlines);
 
     return 1;
@@ -153,10 +317,28 @@ void Video::set_shadow_intensity(float f)
     renderer->set_shadow_intensity(f);
 }
 
-void Video::prepare_frame()
+// Keep the displayed frame before the next logic frame, so later frames can be interpolated from it
+void Video::save_previous()
+{
+    tile_layer->save_previous();
+    sprite_layer->save_previous();
+    hwroad.save_previous();
+}
+
+// alpha: Position between the previous logic frame (0) and the current one (1)
+void Video::prepare_frame(float alpha)
 {
+    if (pipeline_depth > 1)
+    {
+        // Wait for the render thread to finish with the buffer we're about to reuse
+        const uint32_t frame = frames_submitted.load(std::memory_order_relaxed);
+        while (frame - frames_presented.load(std::memory_order_acquire) >= (uint32_t) pipeline_depth)
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+
+        pixels = frame_pixels[frame % pipeline_depth];
+    }
     // Renderer Specific Frame Setup
-    if (!renderer->start_frame())
+    else if (!renderer->start_frame())
         return;
 
     if (!enabled)
@@ -167,9 +349,18 @@ void Video::prepare_frame()
     }
     else
     {
+        const bool blend = alpha < 1.0f;
+
         // OutRun Hardware Video Emulation
         tile_layer->update_tile_values();
 
+        if (blend)
+        {
+            tile_layer->interpolate(alpha);
+            sprite_layer->interpolate(alpha);
+            hwroad.interpolate(alpha);
+        }
+
         (hwroad.*hwroad.render_background)(pixels);
         tile_layer->render_tile_layer(pixels, 1, 0);      // background layer
         tile_layer->render_tile_layer(pixels, 0, 0);      // foreground layer
@@ -178,13 +369,99 @@ void Video::prepare_frame()
             (hwroad.*hwroad.render_foreground)(pixels);
         sprite_layer->render(8);
         tile_layer->render_text_layer(pixels, 1);
+
+        if (blend)
+        {
+            sprite_layer->restore();
+            hwroad.restore();
+        }
      }
 }
 
 void Video::render_frame()
 {
-    renderer->draw_frame(pixels);
-    renderer->finalize_frame();
+    if (pipeline_depth > 1)
+    {
+        const uint32_t frame = frames_submitted.load(std::memory_order_relaxed);
+
+        // Keep the palette as it was when this frame was composed
+        memcpy(frame_palette[frame % pipeline_depth], renderer->get_palette(), S16_PALETTE_ENTRIES * 2 * sizeof(uint32_t));
+        frames_submitted.store(frame + 1, std::memory_order_release);
+
+        if (!render_running)
+            start_pipeline();
+    }
+    else
+    {
+        renderer->draw_frame(pixels, renderer->get_palette());
+        renderer->finalize_frame();
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+// Render Thread
+// ------------------------------------------------------------------------------------------------
+
+void Video::start_pipeline()
+{
+    // The rendering context moves to the render thread
+    renderer->make_current(false);
+    render_running = true;
+    render_thread  = std::thread(&Video::render_loop, this);
+}
+
+// Present any frames still in flight, then return the rendering context to the calling thread
+void Video::stop_pipeline()
+{
+    if (!render_running)
+        return;
+
+    render_running = false;
+    render_thread.join();
+    renderer->make_current(true);
+}
+
+void Video::render_loop()
+{
+    // Don't share the main thread's core. Keep its priority, as it waits for this thread to free a frame.
+    realtime::reset_thread("render", true);
+    renderer->make_current(true);
+
+    for (;;)
+    {
+        const bool running   = render_running;
+        const uint32_t frame = frames_presented.load(std::memory_order_relaxed);
+
+        if (frame == frames_submitted.load(std::memory_order_acquire))
+        {
+            if (!running)
+                break;
+
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            continue;
+        }
+
+        const int slot = frame % pipeline_depth;
+        if (renderer->start_frame())
+        {
+            renderer->draw_frame(frame_pixels[slot], frame_palette[slot]);
+            renderer->finalize_frame();
+        }
+        frames_presented.store(frame + 1, std::memory_order_release);
+    }
+
+    renderer->make_current(false);
+}
+
+// Tile, text, sprite and road RAM, plus the palette
+void Video::add_state(SaveState& state)
+{
+    tile_layer->add_state(state);
+    sprite_layer->add_state(state);
+    hwroad.add_state(state);
+    state.add(palette);
+    state.add(renderer->get_palette(), S16_PALETTE_ENTRIES * 2 * sizeof(uint32_t));
+    state.add(enabled);
 }
 
 bool Video::supports_window()
@@ -312,6 +589,12 @@ void Video::write_sprite16(uint32_t* addr, const uint16_t data)
     *addr += 2;
 }
 
+// Identify the object a sprite entry was drawn from, for interpolation
+void Video::write_sprite_tag(uint32_t addr, const uint16_t tag)
+{
+    sprite_layer->write_tag(addr & 0xfff, tag);
+}
+
 // ---------------------------------------------------------------------------
 // Palette Handling Code
 // ---------------------------------------------------------------------------
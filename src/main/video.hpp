@@ -11,9 +11,12 @@
 
 #pragma once
 
+#include <atomic>
+#include <thread>
 #include "stdint.hpp"
 #include "globals.hpp"
 #include "roms.hpp"
+#include "assetcache.hpp"
 #include "hwvideo/hwtiles.hpp"
 #include "hwvideo/hwsprites.hpp"
 #include "hwvideo/hwroad.hpp"
@@ -27,6 +30,7 @@ namespace shadow
 class hwsprites;
 class RenderBase;
 struct video_settings_t;
+class SaveState;
 
 class Video
 {
@@ -40,12 +44,18 @@ public:
 	Video();
     ~Video();
     
+    bool open_cache(Roms* roms);
+    void decode(Roms* roms);
 	int init(Roms* roms, video_settings_t* settings);
+    int init_layers(Roms* roms);
     void disable();
     int set_video_mode(video_settings_t* settings);
     void set_shadow_intensity(float);
-    void prepare_frame();
+    void save_previous();
+    void prepare_frame(float alpha = 1.0f);
     void render_frame();
+    void stop_pipeline();
+    void add_state(SaveState& state);
     bool supports_window();
     bool supports_vsync();
 
@@ -66,6 +76,7 @@ public:
     uint8_t read_tile8(uint32_t);
 
 	void write_sprite16(uint32_t*, const uint16_t);
+    void write_sprite_tag(uint32_t, const uint16_t);
 
 	void write_pal8(uint32_t*, const uint8_t);
 	void write_pal16(uint32_t*, const uint16_t);
@@ -77,8 +88,36 @@ public:
     uint32_t read_pal32(uint32_t*);
 
 private:
+    // Increment when the decoding of tiles, sprites or road changes
+    const static uint32_t CACHE_FORMAT = 2;
+
+    // Decoded tiles, sprites, road and ROMs from a previous run
+    AssetCache cache;
+
+    // Cache is used in place, as a store shared between instances
+    bool cache_shared;
+
+    void save_cache(Roms* roms);
+
     // SDL Renderer
     RenderBase* renderer;
+
+    // Pipelined rendering: frames are composed on the calling thread, while a render thread converts
+    // and presents the previous one. Each frame in flight has its own pixels and palette.
+    const static int PIPELINE_MAX = 3;
+    int pipeline_depth;                             // Frames in flight (1 = Render on the calling thread)
+    uint16_t* frame_pixels[PIPELINE_MAX];
+    uint32_t* frame_palette[PIPELINE_MAX];
+
+    // Lock-free handoff. Frame n uses buffer (n % pipeline_depth).
+    std::atomic<uint32_t> frames_submitted;
+    std::atomic<uint32_t> frames_presented;
+    std::atomic<bool> render_running;
+    std::thread render_thread;
+
+    void free_frames();
+    void start_pipeline();
+    void render_loop();
     
 	uint8_t palette[S16_PALETTE_ENTRIES * 2]; // 2 Bytes Per Palette Entry
     void refresh_palette(uint32_t);